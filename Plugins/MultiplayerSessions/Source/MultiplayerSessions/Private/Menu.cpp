@@ -4,12 +4,14 @@
 #include "Menu.h"
 #include "Components/Button.h"
 #include "MultiplayerSessionsSubsystem.h"
+#include "MultiplayerSessionEntry.h"
 #include "OnlineSessionSettings.h"
 #include "OnlineSubsystem.h"
 
 void UMenu::MenuSetup(int32 NumberOfPublicConnections, FString TypeOfMatch, FString LobbyPath)
 {
-	PathToLobby = FString::Printf(TEXT("%s?listen"), *LobbyPath);
+	// A dedicated server is already listening; only a player hosting from the menu needs ?listen
+	PathToLobby = IsRunningDedicatedServer() ? LobbyPath : FString::Printf(TEXT("%s?listen"), *LobbyPath);
 	NumPublicConnections = NumberOfPublicConnections;
 	MatchType = TypeOfMatch;
 	AddToViewport();
@@ -43,6 +45,9 @@ void UMenu::MenuSetup(int32 NumberOfPublicConnections, FString TypeOfMatch, FStr
 		MultiplayerSessionsSubsystem->MultiplayerOnJoinSessionComplete.AddUObject(this, &ThisClass::OnJoinSession);
 		MultiplayerSessionsSubsystem->MultiplayerOnDestroySessionComplete.AddDynamic(this, &ThisClass::OnDestroySession);
 		MultiplayerSessionsSubsystem->MultiplayerOnStartSessionComplete.AddDynamic(this, &ThisClass::OnStartSession);
+
+		// Keep a fresh list of sessions while the menu is up, so Join doesn't have to wait for a search
+		MultiplayerSessionsSubsystem->StartSessionBrowsing(MatchType);
 	}
 }
 
@@ -103,24 +108,23 @@ void UMenu::OnFindSessions(const TArray<FOnlineSessionSearchResult>& SessionResu
 		return;
 	}
 
-	for (auto Result : SessionResults)
-	{
-		FString SettingsValue;
-		Result.Session.SessionSettings.Get(FName("MatchType"), SettingsValue);
-		if (SettingsValue == MatchType)
-		{
-			MultiplayerSessionsSubsystem->JoinSession(Result);
-			return;
-		}
-	}
-	if (!bWasSuccessful || SessionResults.Num() == 0)
+	// Already filtered to our match type, a free slot and our build
+	if (bWasSuccessful && SessionResults.Num() > 0)
 	{
-		JoinButton->SetIsEnabled(true);
+		MultiplayerSessionsSubsystem->JoinSession(SessionResults[0]);
+		return;
 	}
+	JoinButton->SetIsEnabled(true);
 }
 
 void UMenu::OnJoinSession(EOnJoinSessionCompleteResult::Type Result)
 {
+	if (Result != EOnJoinSessionCompleteResult::Success)
+	{
+		JoinButton->SetIsEnabled(true);
+		return;
+	}
+
 	IOnlineSubsystem* Subsystem = IOnlineSubsystem::Get();
 	if (Subsystem)
 	{
@@ -161,12 +165,23 @@ void UMenu::JoinButtonClicked()
 	JoinButton->SetIsEnabled(false);
 	if (MultiplayerSessionsSubsystem)
 	{
-		MultiplayerSessionsSubsystem->FindSessions(10000);
+		// Straight in if the background refresh has just seen a session with room
+		if (UMultiplayerSessionEntry* Cached = MultiplayerSessionsSubsystem->FindJoinableCachedSession())
+		{
+			MultiplayerSessionsSubsystem->JoinCachedSession(Cached);
+			return;
+		}
+		MultiplayerSessionsSubsystem->FindSessions(MatchType);
 	}
 }
 
 void UMenu::MenuTearDown()
 {
+	if (MultiplayerSessionsSubsystem)
+	{
+		MultiplayerSessionsSubsystem->StopSessionBrowsing();
+	}
+
 	RemoveFromParent();
 	UWorld* World = GetWorld();
 	if (World)
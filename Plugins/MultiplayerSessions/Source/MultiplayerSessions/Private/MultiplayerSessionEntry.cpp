@@ -0,0 +1,38 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "MultiplayerSessionEntry.h"
+#include "MultiplayerSessionsSubsystem.h"
+
+float UMultiplayerSessionEntry::GetAge() const
+{
+	return static_cast<float>(FPlatformTime::Seconds() - LastSeenTime);
+}
+
+bool UMultiplayerSessionEntry::Update(const FOnlineSessionSearchResult& Result, double Now)
+{
+	const FOnlineSessionSettings& Settings = Result.Session.SessionSettings;
+
+	FString NewMatchType;
+	Settings.Get(UMultiplayerSessionsSubsystem::MatchTypeKey, NewMatchType);
+
+	const int32 NewMaxPlayers = Settings.NumPublicConnections;
+	const int32 NewNumPlayers = FMath::Max(NewMaxPlayers - Result.Session.NumOpenPublicConnections, 0);
+
+	const bool bChanged = Result.PingInMs != PingInMs
+		|| NewNumPlayers != NumPlayers
+		|| NewMaxPlayers != MaxPlayers
+		|| Result.Session.OwningUserName != OwnerName
+		|| NewMatchType != MatchType;
+
+	SessionId = Result.GetSessionIdStr();
+	OwnerName = Result.Session.OwningUserName;
+	MatchType = MoveTemp(NewMatchType);
+	PingInMs = Result.PingInMs;
+	NumPlayers = NewNumPlayers;
+	MaxPlayers = NewMaxPlayers;
+	SearchResult = Result;
+	LastSeenTime = Now;
+
+	return bChanged;
+}
@@ -2,10 +2,16 @@
 
 
 #include "MultiplayerSessionsSubsystem.h"
+#include "MultiplayerSessionEntry.h"
+#include "Engine/GameInstance.h"
+#include "TimerManager.h"
 #include "OnlineSubsystem.h"
 #include "OnlineSessionSettings.h"
 #include "Online/OnlineSessionNames.h"
 
+const FName UMultiplayerSessionsSubsystem::MatchTypeKey(TEXT("MatchType"));
+const FName UMultiplayerSessionsSubsystem::BuildIdKey(TEXT("BuildId"));
+
 UMultiplayerSessionsSubsystem::UMultiplayerSessionsSubsystem():
 	CreateSessionCompleteDelegate(FOnCreateSessionCompleteDelegate::CreateUObject(this, &ThisClass::OnCreateSessionComplete)),
 	FindSessionsCompleteDelegate(FOnFindSessionsCompleteDelegate::CreateUObject(this, &ThisClass::OnFindSessionsComplete)),
@@ -16,6 +22,14 @@ UMultiplayerSessionsSubsystem::UMultiplayerSessionsSubsystem():
 	
 }
 
+void UMultiplayerSessionsSubsystem::Deinitialize()
+{
+	StopSessionBrowsing();
+	CachedSessions.Reset();
+
+	Super::Deinitialize();
+}
+
 void UMultiplayerSessionsSubsystem::CreateSession(int32 NumPublicConnections, FString MatchType)
 {
 	if (!IsValidSessionInterface())
@@ -36,20 +50,35 @@ void UMultiplayerSessionsSubsystem::CreateSession(int32 NumPublicConnections, FS
 	// Store the delegate in a FDelegateHandle so we can later remove it from the delegate list
 	CreateSessionCompleteDelegateHandle = SessionInterface->AddOnCreateSessionCompleteDelegate_Handle(CreateSessionCompleteDelegate);
 
+	// A dedicated server has no local player: no presence or lobby, it advertises as a game server instead
+	const bool bIsDedicated = IsRunningDedicatedServer();
+
 	LastSessionSettings = MakeShareable(new FOnlineSessionSettings());
 	LastSessionSettings->bIsLANMatch = IOnlineSubsystem::Get()->GetSubsystemName() == "NULL" ? true : false;
 	LastSessionSettings->NumPublicConnections = NumPublicConnections;
 	LastSessionSettings->bAllowJoinInProgress = true;
-	LastSessionSettings->bAllowJoinViaPresence = true;
+	LastSessionSettings->bAllowJoinViaPresence = !bIsDedicated;
 	LastSessionSettings->bShouldAdvertise = true;
-	LastSessionSettings->bUsesPresence = true;
-	LastSessionSettings->bUseLobbiesIfAvailable = true;
-	LastSessionSettings->Set(FName("MatchType"), MatchType, EOnlineDataAdvertisementType::ViaOnlineServiceAndPing);
-	LastSessionSettings->BuildUniqueId = 1;
-	LastSessionSettings->bUseLobbiesIfAvailable = true;
-
+	LastSessionSettings->bUsesPresence = !bIsDedicated;
+	LastSessionSettings->bIsDedicated = bIsDedicated;
+	LastSessionSettings->Set(MatchTypeKey, MatchType, EOnlineDataAdvertisementType::ViaOnlineServiceAndPing);
+	// Only clients of the same build can play together; advertised as a setting too so the backend can filter on it
+	LastSessionSettings->BuildUniqueId = GetBuildUniqueId();
+	LastSessionSettings->Set(BuildIdKey, LastSessionSettings->BuildUniqueId, EOnlineDataAdvertisementType::ViaOnlineService);
+	LastSessionSettings->bUseLobbiesIfAvailable = !bIsDedicated;
+
+	bool bCreateStarted = false;
 	const ULocalPlayer* LocalPlayer = GetWorld()->GetFirstLocalPlayerFromController();
-	if (!SessionInterface->CreateSession(*LocalPlayer->GetPreferredUniqueNetId(), NAME_GameSession, *LastSessionSettings))
+	if (LocalPlayer)
+	{
+		bCreateStarted = SessionInterface->CreateSession(*LocalPlayer->GetPreferredUniqueNetId(), NAME_GameSession, *LastSessionSettings);
+	}
+	else if (bIsDedicated)
+	{
+		bCreateStarted = SessionInterface->CreateSession(0, NAME_GameSession, *LastSessionSettings);
+	}
+
+	if (!bCreateStarted)
 	{
 		SessionInterface->ClearOnCreateSessionCompleteDelegate_Handle(CreateSessionCompleteDelegateHandle);
 
@@ -58,7 +87,19 @@ void UMultiplayerSessionsSubsystem::CreateSession(int32 NumPublicConnections, FS
 	}
 }
 
-void UMultiplayerSessionsSubsystem::FindSessions(int32 MaxSearchResults)
+void UMultiplayerSessionsSubsystem::FindSessions(const FString& MatchType, int32 PageSize)
+{
+	// A background refresh is already asking the same question: answer with that
+	if (bSearchInProgress && MatchType == LastSearchMatchType)
+	{
+		bSearchIsForeground = true;
+		return;
+	}
+
+	StartSearch(MatchType, PageSize, true);
+}
+
+void UMultiplayerSessionsSubsystem::StartSearch(const FString& MatchType, int32 PageSize, bool bForeground)
 {
 	if (!IsValidSessionInterface())
 	{
@@ -67,18 +108,195 @@ void UMultiplayerSessionsSubsystem::FindSessions(int32 MaxSearchResults)
 
 	FindSessionsCompleteDelegateHandle = SessionInterface->AddOnFindSessionsCompleteDelegate_Handle(FindSessionsCompleteDelegate);
 
+	LastSearchMatchType = MatchType;
+	LastSearchPageSize = FMath::Max(PageSize, 1);
+	LobbySearchResults.Reset();
+	bLobbySearchSucceeded = false;
+
+	bSearchInProgress = true;
+	bSearchIsForeground = bForeground;
+
+	if (!StartSearchPass(true))
+	{
+		SessionInterface->ClearOnFindSessionsCompleteDelegate_Handle(FindSessionsCompleteDelegateHandle);
+		bSearchInProgress = false;
+
+		if (bSearchIsForeground)
+		{
+			bSearchIsForeground = false;
+			MultiplayerOnFindSessionsComplete.Broadcast(TArray<FOnlineSessionSearchResult>(), false);
+		}
+	}
+}
+
+bool UMultiplayerSessionsSubsystem::StartSearchPass(bool bLobbies)
+{
+	bSearchingLobbies = bLobbies;
+
 	LastSessionSearch = MakeShareable(new FOnlineSessionSearch());
-	LastSessionSearch->MaxSearchResults = MaxSearchResults;
+	LastSessionSearch->MaxSearchResults = LastSearchPageSize;
 	LastSessionSearch->bIsLanQuery = IOnlineSubsystem::Get()->GetSubsystemName() == "NULL" ? true : false;
-	LastSessionSearch->QuerySettings.Set(SEARCH_LOBBIES, true, EOnlineComparisonOp::Equals);
+	LastSessionSearch->QuerySettings.Set(SEARCH_LOBBIES, bLobbies, EOnlineComparisonOp::Equals);
+	if (!bLobbies)
+	{
+		LastSessionSearch->QuerySettings.Set(SEARCH_DEDICATED_ONLY, true, EOnlineComparisonOp::Equals);
+	}
+
+	// Let the backend do the filtering, so only sessions we could join count against the page
+	LastSessionSearch->QuerySettings.Set(MatchTypeKey, LastSearchMatchType, EOnlineComparisonOp::Equals);
+	LastSessionSearch->QuerySettings.Set(BuildIdKey, GetBuildUniqueId(), EOnlineComparisonOp::Equals);
+	LastSessionSearch->QuerySettings.Set(SEARCH_MINSLOTSAVAILABLE, 1, EOnlineComparisonOp::GreaterThanEquals);
 
 	const ULocalPlayer* LocalPlayer = GetWorld()->GetFirstLocalPlayerFromController();
-	if (!SessionInterface->FindSessions(*LocalPlayer->GetPreferredUniqueNetId(), LastSessionSearch.ToSharedRef()))
+	return LocalPlayer && SessionInterface->FindSessions(*LocalPlayer->GetPreferredUniqueNetId(), LastSessionSearch.ToSharedRef());
+}
+
+const TArray<FOnlineSessionSearchResult>& UMultiplayerSessionsSubsystem::GetSearchResults() const
+{
+	static const TArray<FOnlineSessionSearchResult> NoResults;
+	return LastSessionSearch.IsValid() ? LastSessionSearch->SearchResults : NoResults;
+}
+
+TArrayView<const FOnlineSessionSearchResult> UMultiplayerSessionsSubsystem::GetSearchResultsPage(int32 PageIndex, int32 PageSize) const
+{
+	const TArray<FOnlineSessionSearchResult>& Results = GetSearchResults();
+	PageSize = FMath::Max(PageSize, 1);
+
+	const int32 First = PageIndex * PageSize;
+	if (PageIndex < 0 || First >= Results.Num())
 	{
-		SessionInterface->ClearOnFindSessionsCompleteDelegate_Handle(FindSessionsCompleteDelegateHandle);
+		return TArrayView<const FOnlineSessionSearchResult>();
+	}
+	return TArrayView<const FOnlineSessionSearchResult>(Results.GetData() + First, FMath::Min(PageSize, Results.Num() - First));
+}
 
-		MultiplayerOnFindSessionsComplete.Broadcast(TArray<FOnlineSessionSearchResult>(), false);
+int32 UMultiplayerSessionsSubsystem::GetNumSearchResultPages(int32 PageSize) const
+{
+	return FMath::DivideAndRoundUp(GetSearchResults().Num(), FMath::Max(PageSize, 1));
+}
+
+bool UMultiplayerSessionsSubsystem::MatchesSearch(const FOnlineSessionSearchResult& Result, const FString& MatchType)
+{
+	const FOnlineSession& Session = Result.Session;
+	if (Session.NumOpenPublicConnections < 1 || Session.SessionSettings.BuildUniqueId != GetBuildUniqueId())
+	{
+		return false;
+	}
+
+	FString SessionMatchType;
+	return Session.SessionSettings.Get(MatchTypeKey, SessionMatchType) && SessionMatchType == MatchType;
+}
+
+void UMultiplayerSessionsSubsystem::StartSessionBrowsing(const FString& MatchType, float RefreshInterval)
+{
+	UGameInstance* GameInstance = GetGameInstance();
+	if (!GameInstance)
+	{
+		return;
 	}
+
+	// Entries for another match type aren't worth showing
+	if (MatchType != BrowseMatchType)
+	{
+		while (CachedSessions.Num() > 0)
+		{
+			RemoveCachedSession(CachedSessions.Num() - 1);
+		}
+	}
+
+	BrowseMatchType = MatchType;
+	BrowseRefreshInterval = FMath::Max(RefreshInterval, 1.f);
+
+	GameInstance->GetTimerManager().SetTimer(BrowseTimerHandle, this, &ThisClass::RefreshSessionCache, BrowseRefreshInterval, true);
+	RefreshSessionCache();
+}
+
+void UMultiplayerSessionsSubsystem::StopSessionBrowsing()
+{
+	if (UGameInstance* GameInstance = GetGameInstance())
+	{
+		GameInstance->GetTimerManager().ClearTimer(BrowseTimerHandle);
+	}
+}
+
+void UMultiplayerSessionsSubsystem::RefreshSessionCache()
+{
+	if (!bSearchInProgress)
+	{
+		StartSearch(BrowseMatchType, BrowseSearchPageSize, false);
+	}
+}
+
+void UMultiplayerSessionsSubsystem::UpdateSessionCache(const TArray<FOnlineSessionSearchResult>& Results)
+{
+	const double Now = FPlatformTime::Seconds();
+
+	for (const FOnlineSessionSearchResult& Result : Results)
+	{
+		const FString SessionId = Result.GetSessionIdStr();
+		UMultiplayerSessionEntry** Existing = CachedSessions.FindByPredicate([&SessionId](const UMultiplayerSessionEntry* Entry)
+		{
+			return Entry->SessionId == SessionId;
+		});
+
+		if (Existing)
+		{
+			// Only rows whose ping or player count moved need redrawing
+			if ((*Existing)->Update(Result, Now))
+			{
+				(*Existing)->OnUpdated.Broadcast(*Existing);
+			}
+			continue;
+		}
+
+		UMultiplayerSessionEntry* Entry = NewObject<UMultiplayerSessionEntry>(this);
+		Entry->Update(Result, Now);
+		CachedSessions.Add(Entry);
+		MultiplayerOnSessionEntryAdded.Broadcast(Entry);
+	}
+
+	for (int32 Index = CachedSessions.Num() - 1; Index >= 0; --Index)
+	{
+		if (Now - CachedSessions[Index]->LastSeenTime > SessionEntryLifetime)
+		{
+			RemoveCachedSession(Index);
+		}
+	}
+}
+
+void UMultiplayerSessionsSubsystem::RemoveCachedSession(int32 Index)
+{
+	UMultiplayerSessionEntry* Entry = CachedSessions[Index];
+	CachedSessions.RemoveAt(Index);
+	MultiplayerOnSessionEntryRemoved.Broadcast(Entry);
+}
+
+UMultiplayerSessionEntry* UMultiplayerSessionsSubsystem::FindJoinableCachedSession() const
+{
+	// Seen by the last refresh or the one before it: recent enough that it's most likely still there with room
+	const double MinSeenTime = FPlatformTime::Seconds() - BrowseRefreshInterval * 1.5;
+
+	UMultiplayerSessionEntry* Best = nullptr;
+	for (UMultiplayerSessionEntry* Entry : CachedSessions)
+	{
+		if (Entry->LastSeenTime >= MinSeenTime && Entry->HasFreeSlot() && (!Best || Entry->PingInMs < Best->PingInMs))
+		{
+			Best = Entry;
+		}
+	}
+	return Best;
+}
+
+void UMultiplayerSessionsSubsystem::JoinCachedSession(UMultiplayerSessionEntry* Entry)
+{
+	if (!Entry)
+	{
+		MultiplayerOnJoinSessionComplete.Broadcast(EOnJoinSessionCompleteResult::SessionDoesNotExist);
+		return;
+	}
+
+	PendingJoinSessionId = Entry->SessionId;
+	JoinSession(Entry->SearchResult);
 }
 
 void UMultiplayerSessionsSubsystem::JoinSession(const FOnlineSessionSearchResult& SessionResult)
@@ -92,7 +310,7 @@ void UMultiplayerSessionsSubsystem::JoinSession(const FOnlineSessionSearchResult
 	JoinSessionCompleteDelegateHandle = SessionInterface->AddOnJoinSessionCompleteDelegate_Handle(JoinSessionCompleteDelegate);
 
 	const ULocalPlayer* LocalPlayer = GetWorld()->GetFirstLocalPlayerFromController();
-	if (!SessionInterface->JoinSession(*LocalPlayer->GetPreferredUniqueNetId(), NAME_GameSession, SessionResult))
+	if (!LocalPlayer || !SessionInterface->JoinSession(*LocalPlayer->GetPreferredUniqueNetId(), NAME_GameSession, SessionResult))
 	{
 		SessionInterface->ClearOnJoinSessionCompleteDelegate_Handle(JoinSessionCompleteDelegateHandle);
 
@@ -134,6 +352,11 @@ bool UMultiplayerSessionsSubsystem::IsValidSessionInterface()
 	return SessionInterface.IsValid();
 }
 
+bool UMultiplayerSessionsSubsystem::HasActiveSession()
+{
+	return IsValidSessionInterface() && SessionInterface->GetNamedSession(NAME_GameSession) != nullptr;
+}
+
 void UMultiplayerSessionsSubsystem::OnCreateSessionComplete(FName SessionName, bool bWasSuccessful)
 {
 	if (SessionInterface)
@@ -146,11 +369,56 @@ void UMultiplayerSessionsSubsystem::OnCreateSessionComplete(FName SessionName, b
 
 void UMultiplayerSessionsSubsystem::OnFindSessionsComplete(bool bWasSuccessful)
 {
+	// LAN searches (the NULL subsystem) get every session that answers, whatever the query said,
+	// and game server queries can only filter on what fits the server's tags
+	if (LastSessionSearch->bIsLanQuery || !bSearchingLobbies)
+	{
+		LastSessionSearch->SearchResults.RemoveAll([this](const FOnlineSessionSearchResult& Result)
+		{
+			return !MatchesSearch(Result, LastSearchMatchType);
+		});
+	}
+
+	// The lobbies are in; dedicated servers only show up in a game server query, so run that too.
+	// LAN already found both kinds in one go
+	if (bSearchingLobbies && !LastSessionSearch->bIsLanQuery)
+	{
+		bLobbySearchSucceeded = bWasSuccessful;
+		LobbySearchResults = MoveTemp(LastSessionSearch->SearchResults);
+		if (StartSearchPass(false))
+		{
+			return;
+		}
+		bWasSuccessful = false;
+	}
+
 	if (SessionInterface)
 	{
 		SessionInterface->ClearOnFindSessionsCompleteDelegate_Handle(FindSessionsCompleteDelegateHandle);
 	}
 
+	// Lobbies first, then the dedicated servers; either pass answering counts as a successful search
+	LastSessionSearch->SearchResults.Insert(LobbySearchResults, 0);
+	LobbySearchResults.Reset();
+	bWasSuccessful |= bLobbySearchSucceeded;
+	bLobbySearchSucceeded = false;
+
+	bSearchInProgress = false;
+
+	// A failed search still ages the cache, so a lost connection doesn't leave old sessions up
+	if (BrowseTimerHandle.IsValid() && LastSearchMatchType == BrowseMatchType)
+	{
+		static const TArray<FOnlineSessionSearchResult> NoResults;
+		UpdateSessionCache(bWasSuccessful ? LastSessionSearch->SearchResults : NoResults);
+	}
+
+	// A background refresh: nobody is waiting on it
+	if (!bSearchIsForeground)
+	{
+		return;
+	}
+	bSearchIsForeground = false;
+
 	if (LastSessionSearch->SearchResults.Num() <= 0)
 	{
 		MultiplayerOnFindSessionsComplete.Broadcast(TArray<FOnlineSessionSearchResult>(), false);
@@ -167,6 +435,20 @@ void UMultiplayerSessionsSubsystem::OnJoinSessionComplete(FName SessionName, EOn
 		SessionInterface->ClearOnJoinSessionCompleteDelegate_Handle(JoinSessionCompleteDelegateHandle);
 	}
 
+	// The cached session went away or filled up since the last refresh: don't offer it again
+	if (Result != EOnJoinSessionCompleteResult::Success && !PendingJoinSessionId.IsEmpty())
+	{
+		const int32 Index = CachedSessions.IndexOfByPredicate([this](const UMultiplayerSessionEntry* Entry)
+		{
+			return Entry->SessionId == PendingJoinSessionId;
+		});
+		if (Index != INDEX_NONE)
+		{
+			RemoveCachedSession(Index);
+		}
+	}
+	PendingJoinSessionId.Reset();
+
 	MultiplayerOnJoinSessionComplete.Broadcast(Result);
 }
 
@@ -52,7 +52,7 @@ private:
 	void MenuTearDown();
 
 	// The subsystem designed to handle all online session functionality
-	class UMultiplayerSessionsSubsystem* MultiplayerSessionsSubsystem;
+	class UMultiplayerSessionsSubsystem* MultiplayerSessionsSubsystem{ nullptr };
 
 	int32 NumPublicConnections{4};
 	FString MatchType{TEXT("FreeForAll")};
@@ -0,0 +1,63 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/Object.h"
+#include "OnlineSessionSettings.h"
+
+#include "MultiplayerSessionEntry.generated.h"
+
+class UMultiplayerSessionEntry;
+
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FMultiplayerOnSessionEntryUpdated, UMultiplayerSessionEntry*, Entry);
+
+/**
+ * One session in the session browser cache (see UMultiplayerSessionsSubsystem::StartSessionBrowsing).
+ * Entries are UObjects so a server-browser widget can hand them straight to a UListView: the list
+ * only builds rows for what's on screen, and each row binds OnUpdated to refresh its ping and
+ * player count in place when a background search sees the session again.
+ */
+UCLASS(BlueprintType)
+class MULTIPLAYERSESSIONS_API UMultiplayerSessionEntry : public UObject
+{
+	GENERATED_BODY()
+public:
+	UPROPERTY(BlueprintReadOnly, Category = "Session")
+	FString SessionId;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Session")
+	FString OwnerName;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Session")
+	FString MatchType;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Session")
+	int32 PingInMs = 0;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Session")
+	int32 NumPlayers = 0;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Session")
+	int32 MaxPlayers = 0;
+
+	// Broadcast when a refresh changes anything above
+	UPROPERTY(BlueprintAssignable, Category = "Session")
+	FMultiplayerOnSessionEntryUpdated OnUpdated;
+
+	UFUNCTION(BlueprintPure, Category = "Session")
+	bool HasFreeSlot() const { return NumPlayers < MaxPlayers; }
+
+	// Seconds since a search last returned this session
+	UFUNCTION(BlueprintPure, Category = "Session")
+	float GetAge() const;
+
+	// Takes the latest search result for this session. True if anything shown in the browser changed
+	bool Update(const FOnlineSessionSearchResult& Result, double Now);
+
+	// What JoinSession needs; refreshed with everything else
+	FOnlineSessionSearchResult SearchResult;
+
+	// FPlatformTime::Seconds() of the last search that returned this session
+	double LastSeenTime = 0.0;
+};
@@ -8,6 +8,8 @@
 
 #include "MultiplayerSessionsSubsystem.generated.h"
 
+class UMultiplayerSessionEntry;
+
 //
 // Delcaring our own custom delegates for the Menu class to bind callbacks to
 //
@@ -16,6 +18,8 @@ DECLARE_MULTICAST_DELEGATE_TwoParams(FMultiplayerOnFindSessionsComplete, const T
 DECLARE_MULTICAST_DELEGATE_OneParam(FMultiplayerOnJoinSessionComplete, EOnJoinSessionCompleteResult::Type Result);
 DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FMultiplayerOnDestroySessionComplete, bool, bWasSuccessful);
 DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FMultiplayerOnStartSessionComplete, bool, bWasSuccessful);
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FMultiplayerOnSessionEntryAdded, UMultiplayerSessionEntry*, Entry);
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FMultiplayerOnSessionEntryRemoved, UMultiplayerSessionEntry*, Entry);
 
 /**
  * 
@@ -27,17 +31,78 @@ class MULTIPLAYERSESSIONS_API UMultiplayerSessionsSubsystem : public UGameInstan
 public:
 	UMultiplayerSessionsSubsystem();
 
+	virtual void Deinitialize() override;
+
 	//
 	// To handle session functionality. The Menu class will call these
 	//
+	// Works without a local player on a dedicated server; Find/Join need one
 	void CreateSession(int32 NumPublicConnections, FString MatchType);
-	void FindSessions(int32 MaxSearchResults);
+
+	// Looks for joinable sessions of MatchType built from this build, at most PageSize of them.
+	// The filters go to the backend in the query; the NULL subsystem ignores them, so there they're applied to the results instead.
+	// If a background refresh is already searching for MatchType, its results are broadcast instead of starting another search
+	void FindSessions(const FString& MatchType, int32 PageSize = DefaultSearchPageSize);
 	void JoinSession(const FOnlineSessionSearchResult& SessionResult);
 	void DestroySession();
 	void StartSession();
 
 	bool IsValidSessionInterface();
 
+	//
+	// Session browser cache. While browsing, sessions of one match type are searched for in the background
+	// every RefreshInterval; results are merged into a list of entries that stay put (for a list view) and
+	// update in place. Entries no search has returned for SessionEntryLifetime are dropped
+	//
+	UFUNCTION(BlueprintCallable, Category = "Sessions")
+	void StartSessionBrowsing(const FString& MatchType, float RefreshInterval = DefaultRefreshInterval);
+
+	// Stops the refreshes; the cache is kept, and ages out if browsing starts again later
+	UFUNCTION(BlueprintCallable, Category = "Sessions")
+	void StopSessionBrowsing();
+
+	UFUNCTION(BlueprintPure, Category = "Sessions")
+	TArray<UMultiplayerSessionEntry*> GetCachedSessions() const { return CachedSessions; }
+
+	// Lowest ping cached session with a free slot that the last refresh returned, so it can be joined without searching. Null if none
+	UFUNCTION(BlueprintPure, Category = "Sessions")
+	UMultiplayerSessionEntry* FindJoinableCachedSession() const;
+
+	UFUNCTION(BlueprintCallable, Category = "Sessions")
+	void JoinCachedSession(UMultiplayerSessionEntry* Entry);
+
+	UPROPERTY(BlueprintAssignable, Category = "Sessions")
+	FMultiplayerOnSessionEntryAdded MultiplayerOnSessionEntryAdded;
+
+	UPROPERTY(BlueprintAssignable, Category = "Sessions")
+	FMultiplayerOnSessionEntryRemoved MultiplayerOnSessionEntryRemoved;
+
+	static constexpr float DefaultRefreshInterval = 10.f;
+	static constexpr float SessionEntryLifetime = 30.f;
+
+	// A browser lists more than a join needs to look at
+	static constexpr int32 BrowseSearchPageSize = 50;
+
+	// Results of the last search that passed the filters, in the order the backend returned them
+	const TArray<FOnlineSessionSearchResult>& GetSearchResults() const;
+
+	// One page of GetSearchResults, for listing them; empty past the last page
+	TArrayView<const FOnlineSessionSearchResult> GetSearchResultsPage(int32 PageIndex, int32 PageSize = DefaultSearchPageSize) const;
+	int32 GetNumSearchResultPages(int32 PageSize = DefaultSearchPageSize) const;
+
+	// Matches the search's filters, for backends that don't apply them
+	static bool MatchesSearch(const FOnlineSessionSearchResult& Result, const FString& MatchType);
+
+	// Session setting keys we advertise and search on
+	static const FName MatchTypeKey;
+	static const FName BuildIdKey;
+
+	// Enough sessions to find a game with room, without the backend sending us every lobby it has
+	static constexpr int32 DefaultSearchPageSize = 20;
+
+	// True once NAME_GameSession exists, e.g. after a dedicated server created it on its first map
+	bool HasActiveSession();
+
 	//
 	// Our own custom delegates for the Menu class to bind callbacks to
 	//
@@ -60,6 +125,20 @@ protected:
 	void OnStartSessionComplete(FName SessionName, bool bWasSuccessful);
 
 private:
+	// Starts a search; only a foreground one broadcasts MultiplayerOnFindSessionsComplete
+	void StartSearch(const FString& MatchType, int32 PageSize, bool bForeground);
+
+	// One query of a search: Steam keeps lobbies (players hosting) and game servers (dedicated) apart, so it takes one of each
+	bool StartSearchPass(bool bLobbies);
+
+	// Browsing timer: searches again unless a search is still out
+	void RefreshSessionCache();
+
+	// Merges a search's results into the cache and drops entries that have outlived SessionEntryLifetime
+	void UpdateSessionCache(const TArray<FOnlineSessionSearchResult>& Results);
+
+	void RemoveCachedSession(int32 Index);
+
 	IOnlineSessionPtr SessionInterface;
 	TSharedPtr<FOnlineSessionSettings> LastSessionSettings;
 	TSharedPtr<FOnlineSessionSearch> LastSessionSearch;
@@ -79,6 +158,28 @@ private:
 	FOnStartSessionCompleteDelegate StartSessionCompleteDelegate;
 	FDelegateHandle StartSessionCompleteDelegateHandle;
 
+	// Match type the last search was for, for filtering its results by hand
+	FString LastSearchMatchType;
+	int32 LastSearchPageSize{ DefaultSearchPageSize };
+
+	// The lobby pass of the search in progress, kept while the game server pass runs
+	TArray<FOnlineSessionSearchResult> LobbySearchResults;
+	bool bLobbySearchSucceeded{ false };
+	bool bSearchingLobbies{ false };
+
+	bool bSearchInProgress{ false };
+	bool bSearchIsForeground{ false };
+
+	UPROPERTY()
+	TArray<UMultiplayerSessionEntry*> CachedSessions;
+
+	FString BrowseMatchType;
+	float BrowseRefreshInterval{ DefaultRefreshInterval };
+	FTimerHandle BrowseTimerHandle;
+
+	// Session being joined from the cache; dropped from it if the join fails
+	FString PendingJoinSessionId;
+
 	bool bCreateSessionOnDestroy{ false };
 	int32 LastNumPublicConnections;
 	FString LastMatchType;
@@ -0,0 +1,63 @@
+#!/usr/bin/env bash
+# Runs the headless server benchmark (UBallGuysBenchmarkSubsystem) and exits with its status:
+# 0 when every metric is within the baseline's tolerance, 1 on a regression, 2 when the clients
+# didn't all join. Metrics the baseline has no numbers for are reported as not checked and don't
+# fail the run.
+#
+# The server gets loopback bot clients (see RunBotLoad.sh), so replication is measured too. They roll
+# in circles and never ready up, so the server stays in the lobby and every run plays the same scenario.
+#
+#   Scripts/RunBenchmark.sh [extra server args]
+#   Scripts/RunBenchmark.sh -BallGuysBenchmarkWriteBaseline     # record a new baseline on the reference machine
+#   Scripts/RunBenchmark.sh -BallGuysBenchmarkCounts=8,32       # quicker run
+#
+# Results: Saved/Profiling/Benchmarks/*.json and *.csv. Baseline: Config/BallGuysBenchmarkBaseline.json.
+#
+# Environment:
+#   BALLGUYS_SERVER   server binary   (default Binaries/Linux/BallGuysServer)
+#   BALLGUYS_CLIENT   client binary   (default Binaries/Linux/BallGuys)
+#   BALLGUYS_MAP      map             (default /Game/Maps/Lobby)
+#   BALLGUYS_PORT     listen port     (default 7777)
+#   BALLGUYS_CLIENTS  bot clients     (default 8, 0 for a server-only run)
+
+set -euo pipefail
+
+ROOT="$(cd "$(dirname "$0")/.." && pwd)"
+SERVER="${BALLGUYS_SERVER:-$ROOT/Binaries/Linux/BallGuysServer}"
+CLIENT="${BALLGUYS_CLIENT:-$ROOT/Binaries/Linux/BallGuys}"
+MAP="${BALLGUYS_MAP:-/Game/Maps/Lobby}"
+PORT="${BALLGUYS_PORT:-7777}"
+NUM_CLIENTS="${BALLGUYS_CLIENTS:-8}"
+LOG_DIR="$ROOT/Saved/Logs/Benchmark"
+
+NULL_OSS="-ini:Engine:[OnlineSubsystem]:DefaultPlatformService=NULL -nosteam"
+
+mkdir -p "$LOG_DIR"
+CLIENT_PIDS=()
+
+cleanup()
+{
+	for PID in "${CLIENT_PIDS[@]}"; do
+		kill "$PID" 2>/dev/null || true
+	done
+}
+trap cleanup EXIT INT TERM
+
+"$SERVER" "$MAP" -port="$PORT" -BallGuysBenchmark -BallGuysBenchmarkClients="$NUM_CLIENTS" \
+	-nullrhi -nosound -unattended $NULL_OSS -log "$@" &
+SERVER_PID=$!
+
+if ((NUM_CLIENTS > 0)); then
+	# Give the server time to load the map before the first connection
+	sleep 10
+
+	for ((i = 1; i <= NUM_CLIENTS; i++)); do
+		"$CLIENT" "127.0.0.1:$PORT" -BallGuysBot -BallGuysBotMode=Circle -BallGuysBotSeed="$i" -BallGuysBotNoReady \
+			$NULL_OSS -nullrhi -nosound -unattended -log -abslog="$LOG_DIR/Client$i.log" > /dev/null 2>&1 &
+		CLIENT_PIDS+=($!)
+	done
+fi
+
+STATUS=0
+wait "$SERVER_PID" || STATUS=$?
+exit "$STATUS"
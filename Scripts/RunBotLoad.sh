@@ -0,0 +1,62 @@
+#!/usr/bin/env bash
+# Starts a dedicated server plus N headless bot clients on loopback, for server scaling tests.
+#
+#   Scripts/RunBotLoad.sh [NumBots] [Seconds]
+#
+# Everything runs on the NULL online subsystem, so no Steam is needed; the SteamSockets net driver
+# fails to start without Steam and the engine falls back to IpNetDriver.
+# Bots are seeded 1..N, so a run can be repeated.
+#
+# Watch the server with "stat BallGuys", "stat net" or a CSV capture (-csvCaptureFrames / csvprofile start).
+#
+# Environment:
+#   BALLGUYS_SERVER   server binary   (default Binaries/Linux/BallGuysServer)
+#   BALLGUYS_CLIENT   client binary   (default Binaries/Linux/BallGuys)
+#   BALLGUYS_MAP      map to host     (default /Game/Maps/Lobby)
+#   BALLGUYS_PORT     listen port     (default 7777)
+#   BALLGUYS_BOT_MODE Random|Circle   (default Random)
+
+set -euo pipefail
+
+NUM_BOTS="${1:-50}"
+DURATION="${2:-300}"
+
+ROOT="$(cd "$(dirname "$0")/.." && pwd)"
+SERVER="${BALLGUYS_SERVER:-$ROOT/Binaries/Linux/BallGuysServer}"
+CLIENT="${BALLGUYS_CLIENT:-$ROOT/Binaries/Linux/BallGuys}"
+MAP="${BALLGUYS_MAP:-/Game/Maps/Lobby}"
+PORT="${BALLGUYS_PORT:-7777}"
+BOT_MODE="${BALLGUYS_BOT_MODE:-Random}"
+LOG_DIR="$ROOT/Saved/Logs/BotLoad"
+
+NULL_OSS="-ini:Engine:[OnlineSubsystem]:DefaultPlatformService=NULL -nosteam"
+
+mkdir -p "$LOG_DIR"
+PIDS=()
+
+cleanup()
+{
+	for PID in "${PIDS[@]}"; do
+		kill "$PID" 2>/dev/null || true
+	done
+	wait 2>/dev/null || true
+}
+trap cleanup EXIT INT TERM
+
+echo "Server: $MAP on port $PORT"
+"$SERVER" "$MAP" -port="$PORT" $NULL_OSS -log -abslog="$LOG_DIR/Server.log" -unattended > /dev/null 2>&1 &
+PIDS+=($!)
+
+# Give the server time to load the map before the first connection
+sleep 10
+
+for ((i = 1; i <= NUM_BOTS; i++)); do
+	"$CLIENT" "127.0.0.1:$PORT" -BallGuysBot -BallGuysBotMode="$BOT_MODE" -BallGuysBotSeed="$i" \
+		$NULL_OSS -nullrhi -nosound -unattended -log -abslog="$LOG_DIR/Bot$i.log" > /dev/null 2>&1 &
+	PIDS+=($!)
+	# Stagger the joins a little, so login isn't one spike
+	sleep 0.2
+done
+
+echo "$NUM_BOTS bots running for ${DURATION}s, logs in $LOG_DIR"
+sleep "$DURATION"
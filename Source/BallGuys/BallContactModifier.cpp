@@ -0,0 +1,79 @@
+#include "BallContactModifier.h"
+#include "BallGuys.h"
+#include "Chaos/ContactModification.h"
+#include "Chaos/ParticleHandle.h"
+
+void FBallContactModifier::OnContactModification_Internal(Chaos::FCollisionContactModifier& Modifier)
+{
+	// Physics thread
+	BALLGUYS_SCOPE(Knockback);
+
+	if (const FBallContactModifierInput* Input = GetConsumerInput_Internal())
+	{
+		Balls.Reset();
+		for (const FBallContactBall& Ball : Input->Balls)
+		{
+			Balls.Add(Ball.Particle, Ball);
+		}
+	}
+
+	FBallContactModifierOutput& Output = GetProducerOutputData_Internal();
+	SeenPairs.Reset();
+
+	if (Balls.Num() == 0)
+	{
+		return;
+	}
+
+	for (Chaos::FContactPairModifier& Pair : Modifier.GetContacts())
+	{
+		const Chaos::TVec2<Chaos::FGeometryParticleHandle*> Particles = Pair.GetParticlePair();
+		if (!Particles[0] || !Particles[1] || Pair.GetNumContacts() == 0)
+		{
+			continue;
+		}
+
+		const int32 Particle0 = Particles[0]->UniqueIdx().Idx;
+		const int32 Particle1 = Particles[1]->UniqueIdx().Idx;
+		const FBallContactBall* Ball0 = Balls.Find(Particle0);
+		const FBallContactBall* Ball1 = Balls.Find(Particle1);
+
+		if (Ball0 && Ball1)
+		{
+			// One response per pair, however many shape pairs the two bodies produce
+			const uint64 PairKey = (uint64(FMath::Min(Particle0, Particle1)) << 32) | uint32(FMath::Max(Particle0, Particle1));
+			bool bAlreadySeen = false;
+			SeenPairs.Add(PairKey, &bAlreadySeen);
+			if (bAlreadySeen)
+			{
+				continue;
+			}
+
+			// Chaos contact normals point from the second body to the first
+			const float ClosingSpeed = FVector::DotProduct(FVector(Pair.GetParticleVelocity(1) - Pair.GetParticleVelocity(0)), Pair.GetWorldNormal(0));
+
+			Pair.SetRestitution(GetKnockRestitution(
+				FMath::Max(Ball0->Restitution, Ball1->Restitution),
+				FMath::Max(Ball0->SpeedThreshold, Ball1->SpeedThreshold),
+				ClosingSpeed));
+			Pair.SetRestitutionThreshold(RestingSpeedThreshold);
+			Pair.SetInvMassScale0(Ball0->InvMassScale);
+			Pair.SetInvMassScale1(Ball1->InvMassScale);
+			CSV_CUSTOM_STAT(BallGuys, KnockbackPairs, 1, ECsvCustomStatOp::Accumulate);
+		}
+		else if (Ball0 || Ball1)
+		{
+			if (Pair.GetSeparation(0) > TouchingSeparation)
+			{
+				continue;
+			}
+
+			// Chaos contact normals point from the second body to the first
+			const FVector Normal = Pair.GetWorldNormal(0);
+
+			FBallGroundContact& Contact = Output.GroundContacts.AddDefaulted_GetRef();
+			Contact.Particle = Ball0 ? Particle0 : Particle1;
+			Contact.Normal   = Ball0 ? Normal : -Normal;
+		}
+	}
+}
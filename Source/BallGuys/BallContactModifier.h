@@ -0,0 +1,90 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Chaos/SimCallbackInput.h"
+#include "Chaos/SimCallbackObject.h"
+#include "Chaos/ParticleHandleFwd.h"
+
+namespace Chaos
+{
+	class FCollisionContactModifier;
+}
+
+/** One ball as the physics thread sees it. */
+struct FBallContactBall
+{
+	/** Chaos particle unique index of the ball's body. */
+	int32 Particle = INDEX_NONE;
+
+	/** Restitution of ball-ball contacts this ball is in. A pair uses the larger of the two. */
+	float Restitution = 0.f;
+
+	/** Closing speed (cm/s) below which those contacts are capped at restitution 1. A pair uses the larger of the two. */
+	float SpeedThreshold = 0.f;
+
+	/** Below 1 while boosting: the ball acts heavier in the contact, so the other one takes more of the response. */
+	float InvMassScale = 1.f;
+};
+
+/** Game thread -> physics thread: the balls and their knockback response, sent every frame. */
+struct FBallContactModifierInput : public Chaos::FSimCallbackInput
+{
+	TArray<FBallContactBall> Balls;
+
+	void Reset()
+	{
+		Balls.Reset();
+	}
+};
+
+/** A ball touching something that isn't a ball. Normal points out of the other body, toward the ball. */
+struct FBallGroundContact
+{
+	int32 Particle = INDEX_NONE;
+	FVector Normal = FVector::UpVector;
+};
+
+/** Physics thread -> game thread: the ball-vs-world contacts of one step, so no hit events have to be dispatched for them. */
+struct FBallContactModifierOutput : public Chaos::FSimCallbackOutput
+{
+	TArray<FBallGroundContact> GroundContacts;
+
+	void Reset()
+	{
+		GroundContacts.Reset();
+	}
+};
+
+/**
+ * Resolves ball-vs-ball knockback inside the physics step.
+ * Instead of an extra impulse per hit event, each ball-ball contact pair gets the balls'
+ * restitution and a boosted ball's mass scale, once, and the solver does the rest.
+ * Ball-vs-world contacts are only reported back (for the grounded cache), not modified.
+ */
+class FBallContactModifier : public Chaos::TSimCallbackObject<
+	FBallContactModifierInput,
+	FBallContactModifierOutput,
+	Chaos::ESimCallbackOptions::ContactModification>
+{
+public:
+	/** Contacts further apart than this (cm) are speculative and aren't reported as ground. */
+	static constexpr float TouchingSeparation = 1.f;
+
+	/** Ball-ball contacts closing slower than this (cm/s) don't bounce, so balls resting against each other settle. */
+	static constexpr float RestingSpeedThreshold = 100.f;
+
+	/** Restitution of a ball-ball hit: above 1 only when it closes faster than SpeedThreshold, so slow bumps never add energy. */
+	static float GetKnockRestitution(float Restitution, float SpeedThreshold, float ClosingSpeed)
+	{
+		return ClosingSpeed > SpeedThreshold ? Restitution : FMath::Min(Restitution, 1.f);
+	}
+
+private:
+	virtual void OnContactModification_Internal(Chaos::FCollisionContactModifier& Modifier) override;
+
+	/** Latest input, kept for physics steps that don't get a new one. Keyed by particle. */
+	TMap<int32, FBallContactBall> Balls;
+
+	/** Ball-ball pairs already handled this step. */
+	TSet<uint64> SeenPairs;
+};
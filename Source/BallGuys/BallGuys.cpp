@@ -1,6 +1,32 @@
 // Copyright Epic Games, Inc. All Rights Reserved.
 
 #include "BallGuys.h"
+#include "HAL/IConsoleManager.h"
 #include "Modules/ModuleManager.h"
 
 IMPLEMENT_PRIMARY_GAME_MODULE( FDefaultGameModuleImpl, BallGuys, "BallGuys" );
+
+DEFINE_LOG_CATEGORY(LogBallGuys);
+
+DEFINE_STAT(STAT_BallGuys_Input);
+DEFINE_STAT(STAT_BallGuys_InputRPC);
+DEFINE_STAT(STAT_BallGuys_Simulation);
+DEFINE_STAT(STAT_BallGuys_Knockback);
+DEFINE_STAT(STAT_BallGuys_Respawn);
+DEFINE_STAT(STAT_BallGuys_GameLoop);
+DEFINE_STAT(STAT_BallGuys_Hazards);
+
+UE_TRACE_CHANNEL_DEFINE(BallGuysChannel);
+
+CSV_DEFINE_CATEGORY_MODULE(BALLGUYS_API, BallGuys, true);
+
+#if !UE_BUILD_SHIPPING
+
+int32 GBallGuysDebugVerbosity = 0;
+
+static FAutoConsoleVariableRef CVarBallGuysDebugVerbosity(
+	TEXT("BallGuys.Debug.Verbosity"),
+	GBallGuysDebugVerbosity,
+	TEXT("On-screen BallGuys debug text. 0 = off, 1 = events (boost, mapping context), 2 = every input event. Not available in Shipping."));
+
+#endif
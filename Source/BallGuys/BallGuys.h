@@ -3,4 +3,55 @@
 #pragma once
 
 #include "CoreMinimal.h"
+#include "Stats/Stats.h"
+#include "ProfilingDebugging/CsvProfiler.h"
+#include "Trace/Trace.h"
+#include "ProfilingDebugging/CpuProfilerTrace.h"
 
+BALLGUYS_API DECLARE_LOG_CATEGORY_EXTERN(LogBallGuys, Log, All);
+
+// ----------------- Profiling -----------------
+// "stat BallGuys" in game, the BallGuys channel in Insights (-trace=cpu,BallGuys), the BallGuys category in CSV captures
+
+DECLARE_STATS_GROUP(TEXT("BallGuys"), STATGROUP_BallGuys, STATCAT_Advanced);
+
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Input"), STAT_BallGuys_Input, STATGROUP_BallGuys, BALLGUYS_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Input RPC"), STAT_BallGuys_InputRPC, STATGROUP_BallGuys, BALLGUYS_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Simulation"), STAT_BallGuys_Simulation, STATGROUP_BallGuys, BALLGUYS_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Knockback"), STAT_BallGuys_Knockback, STATGROUP_BallGuys, BALLGUYS_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Respawn"), STAT_BallGuys_Respawn, STATGROUP_BallGuys, BALLGUYS_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Game Loop"), STAT_BallGuys_GameLoop, STATGROUP_BallGuys, BALLGUYS_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Hazards"), STAT_BallGuys_Hazards, STATGROUP_BallGuys, BALLGUYS_API);
+
+UE_TRACE_CHANNEL_EXTERN(BallGuysChannel, BALLGUYS_API);
+
+CSV_DECLARE_CATEGORY_MODULE_EXTERN(BALLGUYS_API, BallGuys);
+
+/** Times one scope in stats, Insights and CSV. Name is the suffix of one of the STAT_BallGuys_ stats above. */
+#define BALLGUYS_SCOPE(Name) \
+	SCOPE_CYCLE_COUNTER(STAT_BallGuys_##Name); \
+	TRACE_CPUPROFILER_EVENT_SCOPE_ON_CHANNEL_STR("BallGuys_" #Name, BallGuysChannel); \
+	CSV_SCOPED_TIMING_STAT(BallGuys, Name)
+
+// ----------------- Debug output -----------------
+
+#if !UE_BUILD_SHIPPING
+
+/** BallGuys.Debug.Verbosity: 0 = off, 1 = events, 2 = every input. */
+extern BALLGUYS_API int32 GBallGuysDebugVerbosity;
+
+/** On-screen debug text at or below the current verbosity. The arguments aren't even formatted otherwise, and the whole thing is gone in Shipping. */
+#define BALLGUYS_DEBUG_MESSAGE(Verbosity, Duration, Color, Format, ...) \
+	do \
+	{ \
+		if (GEngine && GBallGuysDebugVerbosity >= (Verbosity)) \
+		{ \
+			GEngine->AddOnScreenDebugMessage(-1, Duration, Color, FString::Printf(Format, ##__VA_ARGS__)); \
+		} \
+	} while (0)
+
+#else
+
+#define BALLGUYS_DEBUG_MESSAGE(Verbosity, Duration, Color, Format, ...) do {} while (0)
+
+#endif
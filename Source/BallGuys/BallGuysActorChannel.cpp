@@ -0,0 +1,13 @@
+#include "BallGuysActorChannel.h"
+#include "BallGuysNetProfiler.h"
+#include "Net/DataBunch.h"
+
+FPacketIdRange UBallGuysActorChannel::SendBunch(FOutBunch* Bunch, bool Merge)
+{
+	if (FBallGuysNetProfiler::IsActive() && Bunch)
+	{
+		FBallGuysNetProfiler::Get().RecordBunch(Connection, Actor, Bunch->GetNumBits(), Bunch->bOpen);
+	}
+
+	return Super::SendBunch(Bunch, Merge);
+}
@@ -0,0 +1,18 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/ActorChannel.h"
+#include "BallGuysActorChannel.generated.h"
+
+/**
+ * Actor channel that reports every outgoing bunch to FBallGuysNetProfiler while it's running.
+ * Registered as the "Actor" channel class in DefaultEngine.ini; otherwise identical to UActorChannel.
+ */
+UCLASS(Transient)
+class BALLGUYS_API UBallGuysActorChannel : public UActorChannel
+{
+	GENERATED_BODY()
+
+public:
+	virtual FPacketIdRange SendBunch(FOutBunch* Bunch, bool Merge) override;
+};
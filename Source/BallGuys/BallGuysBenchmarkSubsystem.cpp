@@ -0,0 +1,492 @@
+#include "BallGuysBenchmarkSubsystem.h"
+#include "BallGuys.h"
+#include "BallGuysBotComponent.h"
+#include "BallGuysReplicationGraph.h"
+#include "BallPawn.h"
+#include "AIController.h"
+#include "Dom/JsonObject.h"
+#include "Engine/NetDriver.h"
+#include "Engine/World.h"
+#include "EngineUtils.h"
+#include "GameFramework/GameModeBase.h"
+#include "GameFramework/PlayerController.h"
+#include "GameFramework/PlayerStart.h"
+#include "HAL/PlatformMemory.h"
+#include "Misc/CommandLine.h"
+#include "Misc/DateTime.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Parse.h"
+#include "Misc/Paths.h"
+#include "Physics/Experimental/PhysScene_Chaos.h"
+#include "Serialization/JsonReader.h"
+#include "Serialization/JsonSerializer.h"
+
+namespace BallGuysBenchmark
+{
+	/** Regressions smaller than this (ms) are noise, whatever the percentage. */
+	constexpr double MinRegressionMs = 0.1;
+
+	/** Spacing (cm) of the spawn grid. */
+	constexpr float SpawnSpacing = 250.f;
+
+	FString GetBaselinePath()
+	{
+		return FPaths::ProjectConfigDir() / TEXT("BallGuysBenchmarkBaseline.json");
+	}
+}
+
+bool UBallGuysBenchmarkSubsystem::ShouldCreateSubsystem(UObject* Outer) const
+{
+	return Super::ShouldCreateSubsystem(Outer) && FParse::Param(FCommandLine::Get(), TEXT("BallGuysBenchmark"));
+}
+
+bool UBallGuysBenchmarkSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UBallGuysBenchmarkSubsystem::OnWorldBeginPlay(UWorld& InWorld)
+{
+	Super::OnWorldBeginPlay(InWorld);
+
+	// Only the server (or standalone) spawns and simulates the balls
+	if (InWorld.GetNetMode() == NM_Client)
+	{
+		return;
+	}
+
+	FString CountsString = TEXT("8,32,64,100");
+	FParse::Value(FCommandLine::Get(), TEXT("BallGuysBenchmarkCounts="), CountsString);
+
+	TArray<FString> CountStrings;
+	CountsString.ParseIntoArray(CountStrings, TEXT(","));
+	for (const FString& Count : CountStrings)
+	{
+		BallCounts.Add(FMath::Max(FCString::Atoi(*Count), 1));
+	}
+
+	FParse::Value(FCommandLine::Get(), TEXT("BallGuysBenchmarkWarmup="), WarmupSeconds);
+	FParse::Value(FCommandLine::Get(), TEXT("BallGuysBenchmarkDuration="), MeasureSeconds);
+	bWriteBaseline = FParse::Param(FCommandLine::Get(), TEXT("BallGuysBenchmarkWriteBaseline"));
+	FParse::Value(FCommandLine::Get(), TEXT("BallGuysBenchmarkClients="), NumClients);
+	FParse::Value(FCommandLine::Get(), TEXT("BallGuysBenchmarkClientTimeout="), ClientTimeoutSeconds);
+	NumClients = FMath::Max(NumClients, 0);
+
+	WorldTickStartHandle = FWorldDelegates::OnWorldTickStart.AddUObject(this, &ThisClass::OnWorldTickStart);
+	WorldPostActorTickHandle = FWorldDelegates::OnWorldPostActorTick.AddUObject(this, &ThisClass::OnWorldPostActorTick);
+	if (FPhysScene* PhysScene = InWorld.GetPhysicsScene())
+	{
+		PhysicsPreTickHandle = PhysScene->OnPhysScenePreTick.AddUObject(this, &ThisClass::OnPhysicsPreTick);
+		PhysicsPostTickHandle = PhysScene->OnPhysScenePostTick.AddUObject(this, &ThisClass::OnPhysicsPostTick);
+	}
+
+	UE_LOG(LogBallGuys, Display, TEXT("Benchmark: %s balls, %d client(s), %.0fs warmup + %.0fs per pass"), *CountsString, NumClients, WarmupSeconds, MeasureSeconds);
+
+	PassIndex = 0;
+	if (NumClients > 0)
+	{
+		Phase = EPhase::WaitForClients;
+		PhaseTime = 0.f;
+		return;
+	}
+	StartPass();
+}
+
+void UBallGuysBenchmarkSubsystem::Deinitialize()
+{
+	FWorldDelegates::OnWorldTickStart.Remove(WorldTickStartHandle);
+	FWorldDelegates::OnWorldPostActorTick.Remove(WorldPostActorTickHandle);
+
+	const UWorld* World = GetWorld();
+	if (FPhysScene* PhysScene = World ? World->GetPhysicsScene() : nullptr)
+	{
+		PhysScene->OnPhysScenePreTick.Remove(PhysicsPreTickHandle);
+		PhysScene->OnPhysScenePostTick.Remove(PhysicsPostTickHandle);
+	}
+
+	Super::Deinitialize();
+}
+
+TStatId UBallGuysBenchmarkSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UBallGuysBenchmarkSubsystem, STATGROUP_BallGuys);
+}
+
+// ----------------- Passes -----------------
+
+void UBallGuysBenchmarkSubsystem::Tick(float DeltaTime)
+{
+	if (Phase == EPhase::Idle || Phase == EPhase::Done)
+	{
+		return;
+	}
+
+	PhaseTime += DeltaTime;
+
+	if (Phase == EPhase::WaitForClients)
+	{
+		// Joined and spawned, so the first pass doesn't measure logins
+		if (GetNumClientBalls() >= NumClients)
+		{
+			UE_LOG(LogBallGuys, Display, TEXT("Benchmark: %d client(s) joined"), NumClients);
+			StartPass();
+		}
+		else if (PhaseTime >= ClientTimeoutSeconds)
+		{
+			UE_LOG(LogBallGuys, Error, TEXT("Benchmark: only %d of %d client(s) joined in %.0fs"), GetNumClientBalls(), NumClients, ClientTimeoutSeconds);
+			Phase = EPhase::Done;
+			FPlatformMisc::RequestExitWithStatus(false, 2);
+		}
+		return;
+	}
+
+	if (Phase == EPhase::Warmup)
+	{
+		if (PhaseTime >= WarmupSeconds)
+		{
+			Phase = EPhase::Measure;
+			PhaseTime = 0.f;
+		}
+		return;
+	}
+
+	// Replication, frame time and memory are sampled once per frame here; game thread and physics by the hooks
+	if (const UNetDriver* NetDriver = GetWorld()->GetNetDriver())
+	{
+		if (const UBallGuysReplicationGraph* Graph = Cast<UBallGuysReplicationGraph>(NetDriver->GetReplicationDriver()))
+		{
+			ReplicationSum += Graph->GetLastReplicateActorsSeconds() * 1000.0;
+		}
+	}
+	FrameSum += DeltaTime * 1000.0;
+	PeakMemoryMB = FMath::Max(PeakMemoryMB, FPlatformMemory::GetStats().UsedPhysical / (1024.0 * 1024.0));
+
+	if (PhaseTime >= MeasureSeconds)
+	{
+		FinishPass();
+	}
+}
+
+void UBallGuysBenchmarkSubsystem::StartPass()
+{
+	if (!BallCounts.IsValidIndex(PassIndex))
+	{
+		Finish();
+		return;
+	}
+
+	GameThreadSamples.Reset();
+	PhysicsSum = 0.0;
+	PhysicsSamples = 0;
+	ReplicationSum = 0.0;
+	FrameSum = 0.0;
+	PeakMemoryMB = 0.0;
+
+	SpawnBalls(BallCounts[PassIndex]);
+
+	Phase = EPhase::Warmup;
+	PhaseTime = 0.f;
+}
+
+void UBallGuysBenchmarkSubsystem::FinishPass()
+{
+	FBallGuysBenchmarkResult& Result = Results.AddDefaulted_GetRef();
+	Result.NumBalls = FMath::Max(BallCounts[PassIndex], NumClients);
+	Result.NumClients = NumClients;
+	Result.NumFrames = GameThreadSamples.Num();
+
+	if (Result.NumFrames > 0)
+	{
+		double Sum = 0.0;
+		for (const double Sample : GameThreadSamples)
+		{
+			Sum += Sample;
+		}
+		Result.GameThreadMs = Sum / Result.NumFrames;
+		Result.ReplicationMs = ReplicationSum / Result.NumFrames;
+		Result.FrameMs = FrameSum / Result.NumFrames;
+
+		GameThreadSamples.Sort();
+		Result.GameThreadP95Ms = GameThreadSamples[FMath::Min(FMath::FloorToInt(Result.NumFrames * 0.95), Result.NumFrames - 1)];
+	}
+	Result.PhysicsFrameMs = PhysicsSamples > 0 ? PhysicsSum / PhysicsSamples : 0.0;
+	Result.PeakMemoryMB = PeakMemoryMB;
+
+	UE_LOG(LogBallGuys, Display, TEXT("Benchmark %3d balls, %d client(s): game thread %.2f ms (p95 %.2f), physics frame %.2f ms, replication %.2f ms, frame %.2f ms, memory %.0f MB"),
+		Result.NumBalls, Result.NumClients, Result.GameThreadMs, Result.GameThreadP95Ms, Result.PhysicsFrameMs, Result.ReplicationMs, Result.FrameMs, Result.PeakMemoryMB);
+
+	DespawnBalls();
+
+	++PassIndex;
+	StartPass();
+}
+
+void UBallGuysBenchmarkSubsystem::SpawnBalls(int32 NumBalls)
+{
+	UWorld* World = GetWorld();
+	const AGameModeBase* GameMode = World->GetAuthGameMode();
+	UClass* PawnClass = GameMode && GameMode->DefaultPawnClass ? GameMode->DefaultPawnClass.Get() : ABallPawn::StaticClass();
+
+	FVector Origin = FVector(0.f, 0.f, 200.f);
+	for (TActorIterator<APlayerStart> It(World); It; ++It)
+	{
+		Origin = It->GetActorLocation();
+		break;
+	}
+
+	// The clients' balls are part of the count
+	const int32 NumClientBalls = GetNumClientBalls();
+	if (NumClientBalls > NumBalls)
+	{
+		UE_LOG(LogBallGuys, Warning, TEXT("Benchmark: %d balls asked for, but the clients already have %d"), NumBalls, NumClientBalls);
+	}
+	NumBalls = FMath::Max(NumBalls - NumClientBalls, 0);
+
+	// Square grid centred on the first player start, close enough that balls keep running into each other
+	const int32 Columns = FMath::CeilToInt(FMath::Sqrt(static_cast<float>(NumBalls)));
+	const FVector GridOffset(-0.5f * (Columns - 1) * BallGuysBenchmark::SpawnSpacing, -0.5f * (Columns - 1) * BallGuysBenchmark::SpawnSpacing, 0.f);
+
+	FActorSpawnParameters Params;
+	Params.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AdjustIfPossibleButAlwaysSpawn;
+
+	for (int32 Index = 0; Index < NumBalls; ++Index)
+	{
+		const FVector Location = Origin + GridOffset + FVector((Index % Columns) * BallGuysBenchmark::SpawnSpacing, (Index / Columns) * BallGuysBenchmark::SpawnSpacing, 0.f);
+
+		ABallPawn* Pawn = World->SpawnActor<ABallPawn>(PawnClass, Location, FRotator::ZeroRotator, Params);
+		AAIController* Controller = World->SpawnActor<AAIController>(Location, FRotator::ZeroRotator);
+		if (!Pawn || !Controller)
+		{
+			continue;
+		}
+		Controller->Possess(Pawn);
+
+		// Same seeds every run, so every run plays the same scenario
+		UBallGuysBotComponent* Bot = NewObject<UBallGuysBotComponent>(Controller);
+		Bot->RegisterComponent();
+		Bot->Mode = EBallGuysBotMode::Circle;
+		Bot->SetSeed(Index + 1);
+
+		Controllers.Add(Controller);
+	}
+}
+
+int32 UBallGuysBenchmarkSubsystem::GetNumClientBalls() const
+{
+	int32 NumClientBalls = 0;
+	for (FConstPlayerControllerIterator It = GetWorld()->GetPlayerControllerIterator(); It; ++It)
+	{
+		const APlayerController* PC = It->Get();
+		if (PC && !PC->IsLocalController() && Cast<ABallPawn>(PC->GetPawn()))
+		{
+			++NumClientBalls;
+		}
+	}
+	return NumClientBalls;
+}
+
+void UBallGuysBenchmarkSubsystem::DespawnBalls()
+{
+	for (AAIController* Controller : Controllers)
+	{
+		if (!IsValid(Controller))
+		{
+			continue;
+		}
+		if (APawn* Pawn = Controller->GetPawn())
+		{
+			Pawn->Destroy();
+		}
+		Controller->Destroy();
+	}
+	Controllers.Reset();
+}
+
+void UBallGuysBenchmarkSubsystem::Finish()
+{
+	Phase = EPhase::Done;
+
+	const FString Timestamp = FDateTime::Now().ToString();
+	const FString Directory = FPaths::ProfilingDir() / TEXT("Benchmarks");
+	WriteResults(Directory / FString::Printf(TEXT("BallGuysBenchmark-%s.json"), *Timestamp), Directory / FString::Printf(TEXT("BallGuysBenchmark-%s.csv"), *Timestamp));
+
+	int32 NumRegressions = 0;
+	int32 NumMissing = 0;
+	if (bWriteBaseline)
+	{
+		FFileHelper::SaveStringToFile(ResultsToJson(DefaultTolerance), *BallGuysBenchmark::GetBaselinePath());
+		UE_LOG(LogBallGuys, Display, TEXT("Benchmark: wrote new baseline %s"), *BallGuysBenchmark::GetBaselinePath());
+	}
+	else
+	{
+		NumRegressions = CompareToBaseline(NumMissing);
+	}
+
+	UE_LOG(LogBallGuys, Display, TEXT("Benchmark: done, %d regression(s)"), NumRegressions);
+	if (NumMissing > 0)
+	{
+		UE_LOG(LogBallGuys, Warning, TEXT("Benchmark: %d metric(s) had no baseline and were NOT checked (record one on the reference machine with -BallGuysBenchmarkWriteBaseline)"), NumMissing);
+	}
+	FPlatformMisc::RequestExitWithStatus(false, NumRegressions > 0 ? 1 : 0);
+}
+
+// ----------------- Results -----------------
+
+FString UBallGuysBenchmarkSubsystem::ResultsToJson(double Tolerance) const
+{
+	TSharedRef<FJsonObject> Root = MakeShared<FJsonObject>();
+	Root->SetNumberField(TEXT("Tolerance"), Tolerance);
+
+	TArray<TSharedPtr<FJsonValue>> Passes;
+	for (const FBallGuysBenchmarkResult& Result : Results)
+	{
+		TSharedRef<FJsonObject> Pass = MakeShared<FJsonObject>();
+		Pass->SetNumberField(TEXT("NumBalls"), Result.NumBalls);
+		Pass->SetNumberField(TEXT("NumClients"), Result.NumClients);
+		Pass->SetNumberField(TEXT("NumFrames"), Result.NumFrames);
+		Pass->SetNumberField(TEXT("GameThreadMs"), Result.GameThreadMs);
+		Pass->SetNumberField(TEXT("GameThreadP95Ms"), Result.GameThreadP95Ms);
+		Pass->SetNumberField(TEXT("PhysicsFrameMs"), Result.PhysicsFrameMs);
+		Pass->SetNumberField(TEXT("ReplicationMs"), Result.ReplicationMs);
+		Pass->SetNumberField(TEXT("FrameMs"), Result.FrameMs);
+		Pass->SetNumberField(TEXT("PeakMemoryMB"), Result.PeakMemoryMB);
+		Passes.Add(MakeShared<FJsonValueObject>(Pass));
+	}
+	Root->SetArrayField(TEXT("Results"), Passes);
+
+	FString Json;
+	const TSharedRef<TJsonWriter<>> Writer = TJsonWriterFactory<>::Create(&Json);
+	FJsonSerializer::Serialize(Root, Writer);
+	return Json;
+}
+
+void UBallGuysBenchmarkSubsystem::WriteResults(const FString& JsonPath, const FString& CsvPath) const
+{
+	FFileHelper::SaveStringToFile(ResultsToJson(DefaultTolerance), *JsonPath);
+
+	FString Csv = TEXT("NumBalls,NumClients,NumFrames,GameThreadMs,GameThreadP95Ms,PhysicsFrameMs,ReplicationMs,FrameMs,PeakMemoryMB\n");
+	for (const FBallGuysBenchmarkResult& Result : Results)
+	{
+		Csv += FString::Printf(TEXT("%d,%d,%d,%.3f,%.3f,%.3f,%.3f,%.3f,%.1f\n"),
+			Result.NumBalls, Result.NumClients, Result.NumFrames, Result.GameThreadMs, Result.GameThreadP95Ms,
+			Result.PhysicsFrameMs, Result.ReplicationMs, Result.FrameMs, Result.PeakMemoryMB);
+	}
+	FFileHelper::SaveStringToFile(Csv, *CsvPath);
+
+	UE_LOG(LogBallGuys, Display, TEXT("Benchmark: results in %s"), *JsonPath);
+}
+
+int32 UBallGuysBenchmarkSubsystem::CompareToBaseline(int32& OutNumMissing) const
+{
+	// The metrics Check looks at below, for counting what a missing pass leaves unchecked
+	auto GetNumMetrics = [](const FBallGuysBenchmarkResult& Result)
+	{
+		return Result.NumClients > 0 ? 5 : 4;
+	};
+
+	OutNumMissing = 0;
+
+	FString BaselineString;
+	TSharedPtr<FJsonObject> Baseline;
+	const TArray<TSharedPtr<FJsonValue>>* BaselinePasses = nullptr;
+	if (!FFileHelper::LoadFileToString(BaselineString, *BallGuysBenchmark::GetBaselinePath())
+		|| !FJsonSerializer::Deserialize(TJsonReaderFactory<>::Create(BaselineString), Baseline)
+		|| !Baseline.IsValid()
+		|| !Baseline->TryGetArrayField(TEXT("Results"), BaselinePasses))
+	{
+		UE_LOG(LogBallGuys, Warning, TEXT("Benchmark: no baseline at %s, nothing to compare"), *BallGuysBenchmark::GetBaselinePath());
+		for (const FBallGuysBenchmarkResult& Result : Results)
+		{
+			OutNumMissing += GetNumMetrics(Result);
+		}
+		return 0;
+	}
+
+	double Tolerance = DefaultTolerance;
+	Baseline->TryGetNumberField(TEXT("Tolerance"), Tolerance);
+
+	int32 NumRegressions = 0;
+	for (const FBallGuysBenchmarkResult& Result : Results)
+	{
+		const TSharedPtr<FJsonObject>* Match = nullptr;
+		for (const TSharedPtr<FJsonValue>& Value : *BaselinePasses)
+		{
+			const TSharedPtr<FJsonObject>* Pass = nullptr;
+			int32 NumBalls = 0;
+			int32 PassClients = 0;
+			if (Value->TryGetObject(Pass) && (*Pass)->TryGetNumberField(TEXT("NumBalls"), NumBalls) && NumBalls == Result.NumBalls
+				&& (*Pass)->TryGetNumberField(TEXT("NumClients"), PassClients) && PassClients == Result.NumClients)
+			{
+				Match = Pass;
+				break;
+			}
+		}
+		if (!Match)
+		{
+			UE_LOG(LogBallGuys, Warning, TEXT("Benchmark: no baseline for %d balls, %d client(s)"), Result.NumBalls, Result.NumClients);
+			OutNumMissing += GetNumMetrics(Result);
+			continue;
+		}
+
+		auto Check = [&](const TCHAR* Metric, double Value, double MinDelta)
+		{
+			double BaselineValue = 0.0;
+			if (!(*Match)->TryGetNumberField(Metric, BaselineValue))
+			{
+				UE_LOG(LogBallGuys, Warning, TEXT("Benchmark: no baseline %s for %d balls"), Metric, Result.NumBalls);
+				++OutNumMissing;
+				return;
+			}
+			if (Value > BaselineValue * (1.0 + Tolerance) && Value - BaselineValue > MinDelta)
+			{
+				UE_LOG(LogBallGuys, Error, TEXT("Benchmark REGRESSION: %d balls %s %.3f, baseline %.3f (+%.0f%%, tolerance %.0f%%)"),
+					Result.NumBalls, Metric, Value, BaselineValue, BaselineValue > 0.0 ? 100.0 * (Value / BaselineValue - 1.0) : 100.0, 100.0 * Tolerance);
+				++NumRegressions;
+			}
+		};
+
+		Check(TEXT("GameThreadMs"), Result.GameThreadMs, BallGuysBenchmark::MinRegressionMs);
+		Check(TEXT("GameThreadP95Ms"), Result.GameThreadP95Ms, BallGuysBenchmark::MinRegressionMs);
+		Check(TEXT("PhysicsFrameMs"), Result.PhysicsFrameMs, BallGuysBenchmark::MinRegressionMs);
+		if (Result.NumClients > 0)
+		{
+			// Nothing to replicate to without clients
+			Check(TEXT("ReplicationMs"), Result.ReplicationMs, BallGuysBenchmark::MinRegressionMs);
+		}
+		Check(TEXT("PeakMemoryMB"), Result.PeakMemoryMB, 1.0);
+	}
+
+	return NumRegressions;
+}
+
+// ----------------- Frame timing hooks -----------------
+
+void UBallGuysBenchmarkSubsystem::OnWorldTickStart(UWorld* InWorld, ELevelTick TickType, float DeltaSeconds)
+{
+	if (InWorld == GetWorld())
+	{
+		WorldTickStartTime = FPlatformTime::Seconds();
+	}
+}
+
+void UBallGuysBenchmarkSubsystem::OnWorldPostActorTick(UWorld* InWorld, ELevelTick TickType, float DeltaSeconds)
+{
+	if (InWorld == GetWorld() && Phase == EPhase::Measure && WorldTickStartTime > 0.0)
+	{
+		GameThreadSamples.Add((FPlatformTime::Seconds() - WorldTickStartTime) * 1000.0);
+	}
+}
+
+void UBallGuysBenchmarkSubsystem::OnPhysicsPreTick(FChaosScene* Scene, float DeltaSeconds)
+{
+	PhysicsStartTime = FPlatformTime::Seconds();
+}
+
+void UBallGuysBenchmarkSubsystem::OnPhysicsPostTick(FChaosScene* Scene)
+{
+	if (Phase == EPhase::Measure && PhysicsStartTime > 0.0)
+	{
+		PhysicsSum += (FPlatformTime::Seconds() - PhysicsStartTime) * 1000.0;
+		++PhysicsSamples;
+	}
+}
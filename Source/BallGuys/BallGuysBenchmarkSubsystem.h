@@ -0,0 +1,128 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "BallGuysBenchmarkSubsystem.generated.h"
+
+class AAIController;
+class FChaosScene;
+
+/** Averages and peaks of one benchmark pass (one ball count). */
+struct FBallGuysBenchmarkResult
+{
+	int32 NumBalls = 0;
+	int32 NumClients = 0;
+	int32 NumFrames = 0;
+
+	double GameThreadMs = 0.0;      // world tick, start to end of actor ticking
+	double GameThreadP95Ms = 0.0;
+	double PhysicsFrameMs = 0.0;    // game thread wall time from the physics scene's start of frame (solver kicked off)
+	                                // to its end (solver synced); work during physics overlaps it, so it's not solver time
+	double ReplicationMs = 0.0;     // replication graph ServerReplicateActors, to the connected clients
+	double FrameMs = 0.0;
+	double PeakMemoryMB = 0.0;      // used physical memory
+};
+
+/**
+ * Headless server performance benchmark.
+ * Only created when the game runs with -BallGuysBenchmark, e.g.
+ *   BallGuysServer /Game/Maps/Lobby -BallGuysBenchmark -nullrhi -unattended
+ *
+ * With -BallGuysBenchmarkClients=N it first waits for N clients to join, so there's something to
+ * replicate to: Scripts/RunBenchmark.sh starts them as loopback bot clients (-BallGuysBot, Circle
+ * mode, -BallGuysBotNoReady so no match starts). Their balls count towards every pass's ball count.
+ *
+ * For each ball count it tops the clients' balls up with ABallPawns possessed by AI controllers driven by
+ * UBallGuysBotComponent in Circle mode (fixed seeds, so every run plays the same scenario),
+ * warms up, measures, and despawns them. Results are written as JSON and CSV to
+ * Saved/Profiling/Benchmarks and compared against Config/BallGuysBenchmarkBaseline.json. The process
+ * exits with 1 if any metric regressed past the baseline's tolerance, 2 if the clients didn't all join,
+ * 0 otherwise. Metrics the baseline has no value for aren't checked: they're logged as such and don't
+ * fail the run. Passes are matched to the baseline by ball and client count.
+ *
+ * Command line:
+ *   -BallGuysBenchmarkCounts=8,32,64,100
+ *   -BallGuysBenchmarkClients=8 -BallGuysBenchmarkClientTimeout=60   (clients to wait for, 0 for none)
+ *   -BallGuysBenchmarkWarmup=3 -BallGuysBenchmarkDuration=10   (seconds per pass)
+ *   -BallGuysBenchmarkWriteBaseline                             (store this run as the new baseline)
+ */
+UCLASS()
+class BALLGUYS_API UBallGuysBenchmarkSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual bool ShouldCreateSubsystem(UObject* Outer) const override;
+	virtual void OnWorldBeginPlay(UWorld& InWorld) override;
+	virtual void Deinitialize() override;
+
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+
+protected:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+private:
+	enum class EPhase : uint8
+	{
+		Idle,
+		WaitForClients,
+		Warmup,
+		Measure,
+		Done
+	};
+
+	void StartPass();
+	void FinishPass();
+	void SpawnBalls(int32 NumBalls);
+	int32 GetNumClientBalls() const;
+	void DespawnBalls();
+	void Finish();
+
+	void WriteResults(const FString& JsonPath, const FString& CsvPath) const;
+	FString ResultsToJson(double Tolerance) const;
+
+	/** Compares against the stored baseline. Returns the number of regressed metrics; OutNumMissing counts the ones the baseline has no value for. */
+	int32 CompareToBaseline(int32& OutNumMissing) const;
+
+	// Frame timing hooks
+	void OnWorldTickStart(UWorld* InWorld, ELevelTick TickType, float DeltaSeconds);
+	void OnWorldPostActorTick(UWorld* InWorld, ELevelTick TickType, float DeltaSeconds);
+	// Physics frame hooks: OnPhysScenePreTick/PostTick fire on the game thread around the solver's dispatch and sync
+	void OnPhysicsPreTick(FChaosScene* Scene, float DeltaSeconds);
+	void OnPhysicsPostTick(FChaosScene* Scene);
+
+	TArray<int32> BallCounts;
+	float WarmupSeconds = 3.f;
+	float MeasureSeconds = 10.f;
+	bool bWriteBaseline = false;
+	int32 NumClients = 0;
+	float ClientTimeoutSeconds = 60.f;
+
+	EPhase Phase = EPhase::Idle;
+	int32 PassIndex = 0;
+	float PhaseTime = 0.f;
+
+	UPROPERTY()
+	TArray<AAIController*> Controllers;
+
+	// Samples of the pass being measured
+	TArray<double> GameThreadSamples;
+	double PhysicsSum = 0.0;
+	int32 PhysicsSamples = 0;
+	double ReplicationSum = 0.0;
+	double FrameSum = 0.0;
+	double PeakMemoryMB = 0.0;
+
+	double WorldTickStartTime = 0.0;
+	double PhysicsStartTime = 0.0;
+
+	TArray<FBallGuysBenchmarkResult> Results;
+
+	FDelegateHandle WorldTickStartHandle;
+	FDelegateHandle WorldPostActorTickHandle;
+	FDelegateHandle PhysicsPreTickHandle;
+	FDelegateHandle PhysicsPostTickHandle;
+
+	static constexpr double DefaultTolerance = 0.15;
+};
@@ -0,0 +1,120 @@
+#include "BallGuysBotComponent.h"
+#include "BallGuys.h"
+#include "BallGuysPlayerController.h"
+#include "BallGuysPlayerState.h"
+#include "BallPawn.h"
+#include "Misc/CommandLine.h"
+#include "Misc/Parse.h"
+
+UBallGuysBotComponent::UBallGuysBotComponent()
+{
+	PrimaryComponentTick.bCanEverTick = true;
+}
+
+bool UBallGuysBotComponent::IsBotClient()
+{
+	return FParse::Param(FCommandLine::Get(), TEXT("BallGuysBot"));
+}
+
+void UBallGuysBotComponent::BeginPlay()
+{
+	Super::BeginPlay();
+
+	FString ModeName;
+	if (FParse::Value(FCommandLine::Get(), TEXT("BallGuysBotMode="), ModeName))
+	{
+		Mode = ModeName.Equals(TEXT("Circle"), ESearchCase::IgnoreCase) ? EBallGuysBotMode::Circle : EBallGuysBotMode::Random;
+	}
+
+	int32 Seed = 0;
+	if (!FParse::Value(FCommandLine::Get(), TEXT("BallGuysBotSeed="), Seed))
+	{
+		Seed = static_cast<int32>(FPlatformTime::Cycles());
+	}
+	SetSeed(Seed);
+
+	if (FParse::Param(FCommandLine::Get(), TEXT("BallGuysBotNoReady")))
+	{
+		bReadyUp = false;
+	}
+
+	UE_LOG(LogBallGuys, Log, TEXT("Bot client: mode %s, seed %d"), Mode == EBallGuysBotMode::Circle ? TEXT("Circle") : TEXT("Random"), Seed);
+}
+
+void UBallGuysBotComponent::SetSeed(int32 Seed)
+{
+	Random.Initialize(Seed);
+	Heading = Random.FRandRange(0.f, 360.f);
+	NextDecisionTime = 0.0;
+}
+
+void UBallGuysBotComponent::TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
+{
+	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+
+	TickReady(DeltaTime);
+
+	AController* Controller = Cast<AController>(GetOwner());
+	ABallPawn* Pawn = Controller ? Cast<ABallPawn>(Controller->GetPawn()) : nullptr;
+	if (!Pawn)
+	{
+		return;
+	}
+
+	if (Mode == EBallGuysBotMode::Circle)
+	{
+		Heading = FMath::Fmod(Heading + CircleTurnRate * DeltaTime, 360.f);
+		MoveAxis = FVector2D(0.f, 1.f);
+	}
+	else
+	{
+		TickRandom(Pawn);
+	}
+
+	// Movement is relative to the control rotation, like a player steering with the camera
+	Controller->SetControlRotation(FRotator(0.f, Heading, 0.f));
+	Pawn->SetScriptedMoveInput(MoveAxis);
+}
+
+void UBallGuysBotComponent::TickRandom(ABallPawn* Pawn)
+{
+	const double Now = GetWorld()->GetTimeSeconds();
+	if (Now < NextDecisionTime)
+	{
+		return;
+	}
+	NextDecisionTime = Now + Random.FRandRange(DecisionInterval.X, DecisionInterval.Y);
+
+	Heading = Random.FRandRange(0.f, 360.f);
+	// Stand still now and then, so the server also sees idle balls
+	MoveAxis = Random.FRand() < 0.15f ? FVector2D::ZeroVector : FVector2D(0.f, 1.f);
+
+	if (Random.FRand() < JumpChance)
+	{
+		Pawn->PressScriptedJump();
+	}
+	if (Random.FRand() < BoostChance && Pawn->GetCooldownTimeRemaining() <= 0.f)
+	{
+		Pawn->PressScriptedBoost();
+	}
+}
+
+void UBallGuysBotComponent::TickReady(float DeltaTime)
+{
+	ABallGuysPlayerController* PC = Cast<ABallGuysPlayerController>(GetOwner());
+	const ABallGuysPlayerState* PS = PC ? PC->GetPlayerState<ABallGuysPlayerState>() : nullptr;
+	if (!bReadyUp || !PS || PS->bIsReady)
+	{
+		NotReadyTime = 0.f;
+		return;
+	}
+
+	// Only player controllers take part in the ready-up; benchmark bots (AI controllers) just play
+	// Wait a bit, so the ready RPC isn't resent every frame before the replicated flag comes back
+	NotReadyTime += DeltaTime;
+	if (NotReadyTime >= ReadyDelay)
+	{
+		PC->ToggleReadyState();
+		NotReadyTime = 0.f;
+	}
+}
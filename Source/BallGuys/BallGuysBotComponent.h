@@ -0,0 +1,84 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/ActorComponent.h"
+#include "BallGuysBotComponent.generated.h"
+
+UENUM()
+enum class EBallGuysBotMode : uint8
+{
+	/** Wander: a new random direction every few seconds, with random jumps and boosts. */
+	Random,
+	/** Roll in a circle at a fixed rate; the same every run, good for comparing numbers. */
+	Circle
+};
+
+/**
+ * Drives the owning controller's ball like a player would, for load tests.
+ * Added by ABallGuysPlayerController on a client started with -BallGuysBot, and by the benchmark to its AI controllers.
+ * Input goes through ABallPawn's scripted input entry points, i.e. the same input stream and
+ * RPC as HandleMove/HandleJump/HandleBoost, and the bot readies up so matches actually start.
+ *
+ * Command line:
+ *   -BallGuysBot                  enable
+ *   -BallGuysBotMode=Random|Circle
+ *   -BallGuysBotSeed=N            random seed, so a run can be repeated
+ *   -BallGuysBotNoReady           never ready up, so no match starts (the benchmark's clients)
+ */
+UCLASS(ClassGroup = (BallGuys))
+class BALLGUYS_API UBallGuysBotComponent : public UActorComponent
+{
+	GENERATED_BODY()
+
+public:
+	UBallGuysBotComponent();
+
+	/** True if this process was started as a bot client. */
+	static bool IsBotClient();
+
+	virtual void TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
+
+	/** Restarts the random sequence. BeginPlay seeds from the command line, or the clock. */
+	void SetSeed(int32 Seed);
+
+	UPROPERTY(EditAnywhere, Category = "Bot")
+	EBallGuysBotMode Mode = EBallGuysBotMode::Random;
+
+	/** Random mode: seconds between direction changes. */
+	UPROPERTY(EditAnywhere, Category = "Bot")
+	FVector2D DecisionInterval = FVector2D(1.f, 3.f);
+
+	/** Random mode: chance to jump at each decision. */
+	UPROPERTY(EditAnywhere, Category = "Bot", meta = (ClampMin = "0", ClampMax = "1"))
+	float JumpChance = 0.25f;
+
+	/** Random mode: chance to boost at each decision, if it's off cooldown. */
+	UPROPERTY(EditAnywhere, Category = "Bot", meta = (ClampMin = "0", ClampMax = "1"))
+	float BoostChance = 0.3f;
+
+	/** Circle mode: how fast the heading turns (degrees per second). */
+	UPROPERTY(EditAnywhere, Category = "Bot")
+	float CircleTurnRate = 45.f;
+
+	/** How long to wait after joining (and after being un-readied) before readying up. */
+	UPROPERTY(EditAnywhere, Category = "Bot")
+	float ReadyDelay = 2.f;
+
+	/** Whether to ready up at all. */
+	UPROPERTY(EditAnywhere, Category = "Bot")
+	bool bReadyUp = true;
+
+protected:
+	virtual void BeginPlay() override;
+
+private:
+	void TickReady(float DeltaTime);
+	void TickRandom(class ABallPawn* Pawn);
+
+	FRandomStream Random;
+
+	FVector2D MoveAxis = FVector2D::ZeroVector;
+	float Heading = 0.f;
+	double NextDecisionTime = 0.0;
+	float NotReadyTime = 0.f;
+};
@@ -0,0 +1,143 @@
+#include "BallGuysClockSubsystem.h"
+#include "BallGuys.h"
+#include "BallGuysPlayerController.h"
+#include "Engine/World.h"
+#include "GameFramework/GameStateBase.h"
+#include "TimerManager.h"
+
+bool UBallGuysClockSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UBallGuysClockSubsystem::OnWorldBeginPlay(UWorld& InWorld)
+{
+	Super::OnWorldBeginPlay(InWorld);
+
+	// The server's clock is the reference
+	if (InWorld.GetNetMode() != NM_Client)
+	{
+		return;
+	}
+
+	Samples.Reserve(MaxSamples);
+	InWorld.GetTimerManager().SetTimer(RequestTimerHandle, this, &UBallGuysClockSubsystem::SendRequest, BurstInterval, true);
+}
+
+void UBallGuysClockSubsystem::Deinitialize()
+{
+	if (UWorld* World = GetWorld())
+	{
+		World->GetTimerManager().ClearTimer(RequestTimerHandle);
+	}
+	Samples.Reset();
+
+	Super::Deinitialize();
+}
+
+double UBallGuysClockSubsystem::GetServerTime() const
+{
+	const UWorld* World = GetWorld();
+	if (!World)
+	{
+		return 0.0;
+	}
+	if (World->GetNetMode() != NM_Client)
+	{
+		return World->GetTimeSeconds();
+	}
+	if (bSynchronized)
+	{
+		return GetLocalTime() + Offset;
+	}
+
+	const AGameStateBase* GameState = World->GetGameState();
+	return GameState ? GameState->GetServerWorldTimeSeconds() : World->GetTimeSeconds();
+}
+
+double UBallGuysClockSubsystem::GetServerTime(const UWorld* World)
+{
+	if (!World)
+	{
+		return 0.0;
+	}
+
+	const UBallGuysClockSubsystem* Clock = World->GetSubsystem<UBallGuysClockSubsystem>();
+	return Clock ? Clock->GetServerTime() : World->GetTimeSeconds();
+}
+
+void UBallGuysClockSubsystem::SendRequest()
+{
+	// The player controller is what we can send through; it may not have arrived yet
+	ABallGuysPlayerController* PlayerController = Cast<ABallGuysPlayerController>(GetWorld()->GetFirstPlayerController());
+	if (!PlayerController)
+	{
+		return;
+	}
+
+	PlayerController->Server_RequestClockSync(GetLocalTime());
+
+	if (++NumRequestsSent == BurstSamples)
+	{
+		GetWorld()->GetTimerManager().SetTimer(RequestTimerHandle, this, &UBallGuysClockSubsystem::SendRequest, SyncInterval, true);
+	}
+}
+
+void UBallGuysClockSubsystem::AddSample(double ClientSendTime, double ServerTime)
+{
+	const double Now = GetLocalTime();
+	const double SampleRoundTrip = Now - ClientSendTime;
+	if (SampleRoundTrip < 0.0)
+	{
+		return;
+	}
+
+	// The server stamped its reply about half a round trip ago
+	FSample Sample;
+	Sample.RoundTripTime = SampleRoundTrip;
+	Sample.Offset = ServerTime + SampleRoundTrip * 0.5 - Now;
+
+	if (Samples.Num() < MaxSamples)
+	{
+		Samples.Add(Sample);
+	}
+	else
+	{
+		Samples[NextSample] = Sample;
+	}
+	NextSample = (NextSample + 1) % MaxSamples;
+
+	// Queuing only ever adds delay, and adds it to one direction more than the other:
+	// the quickest round trips are the ones whose midpoint is closest to the truth
+	TArray<FSample, TInlineAllocator<MaxSamples>> Sorted(Samples);
+	Sorted.Sort([](const FSample& A, const FSample& B) { return A.RoundTripTime < B.RoundTripTime; });
+
+	const int32 NumBest = FMath::Max(Sorted.Num() / 3, 1);
+	double BestOffset = 0.0;
+	double BestRoundTrip = 0.0;
+	for (int32 Index = 0; Index < NumBest; ++Index)
+	{
+		BestOffset += Sorted[Index].Offset;
+		BestRoundTrip += Sorted[Index].RoundTripTime;
+	}
+	BestOffset /= NumBest;
+	RoundTripTime = BestRoundTrip / NumBest;
+
+	const double Error = BestOffset - Offset;
+	if (!bSynchronized || FMath::Abs(Error) > SnapThreshold)
+	{
+		if (bSynchronized)
+		{
+			UE_LOG(LogBallGuys, Log, TEXT("Clock: off by %.0f ms, snapping"), Error * 1000.0);
+		}
+		Offset = BestOffset;
+		bSynchronized = true;
+	}
+	else
+	{
+		Offset += FMath::Clamp(Error, -MaxSlewPerSample, MaxSlewPerSample);
+	}
+
+	CSV_CUSTOM_STAT(BallGuys, ClockRoundTripMs, static_cast<float>(RoundTripTime * 1000.0), ECsvCustomStatOp::Set);
+	CSV_CUSTOM_STAT(BallGuys, ClockErrorMs, static_cast<float>(Error * 1000.0), ECsvCustomStatOp::Set);
+}
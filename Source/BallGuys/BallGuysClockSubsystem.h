@@ -0,0 +1,76 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "BallGuysClockSubsystem.generated.h"
+
+/**
+ * Server clock for every machine: the server's world time, and on clients an NTP-style estimate of it.
+ *
+ * Clients ping the server through ABallGuysPlayerController (a burst right after joining, then every
+ * SyncInterval). Each round trip gives a sample: RTT, and the offset that puts the server's reply time
+ * half an RTT before it arrived. The samples with the lowest RTT are the ones least delayed by queuing,
+ * so the estimate is the mean offset of the best third of the last MaxSamples. The clock slews towards
+ * new estimates rather than jumping, so it never runs backwards by more than a few milliseconds.
+ *
+ * Everything that compares times across machines (match phases, boosts, replicated ball states,
+ * input timestamps) reads GetServerTime(World).
+ */
+UCLASS()
+class BALLGUYS_API UBallGuysClockSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void OnWorldBeginPlay(UWorld& InWorld) override;
+	virtual void Deinitialize() override;
+
+	/** Server time as this machine best knows it. Falls back to the game state's estimate until the first sample. */
+	double GetServerTime() const;
+
+	/** GetServerTime of World's clock, or World's own time when there is none. */
+	static double GetServerTime(const UWorld* World);
+
+	/** Clients: filtered round trip time (seconds). 0 on the server. */
+	double GetRoundTripTime() const { return RoundTripTime; }
+
+	bool IsSynchronized() const { return bSynchronized; }
+
+	/** Clients: a reply to one of our sync requests. ClientSendTime is ours, echoed back. */
+	void AddSample(double ClientSendTime, double ServerTime);
+
+	static constexpr int32 MaxSamples = 16;
+	static constexpr int32 BurstSamples = 6;
+	static constexpr float BurstInterval = 0.1f;
+	static constexpr float SyncInterval = 2.f;
+
+	/** Largest correction applied per sample, once synchronized; anything past SnapThreshold is applied at once. */
+	static constexpr double MaxSlewPerSample = 0.005;
+	static constexpr double SnapThreshold = 0.25;
+
+protected:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+private:
+	struct FSample
+	{
+		double RoundTripTime = 0.0;
+		double Offset = 0.0;
+	};
+
+	void SendRequest();
+
+	/** Local clock the offset applies to: unaffected by pauses, dilation or hitches in our world. */
+	static double GetLocalTime() { return FPlatformTime::Seconds(); }
+
+	TArray<FSample> Samples;
+	int32 NextSample = 0;
+	int32 NumRequestsSent = 0;
+
+	/** Server time = local time + Offset. */
+	double Offset = 0.0;
+	double RoundTripTime = 0.0;
+	bool bSynchronized = false;
+
+	FTimerHandle RequestTimerHandle;
+};
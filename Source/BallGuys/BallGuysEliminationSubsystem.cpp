@@ -0,0 +1,85 @@
+#include "BallGuysEliminationSubsystem.h"
+#include "BallGuys.h"
+
+bool UBallGuysEliminationSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UBallGuysEliminationSubsystem::Deinitialize()
+{
+	Zones.Reset();
+
+	Super::Deinitialize();
+}
+
+void UBallGuysEliminationSubsystem::RegisterZone(const UObject* Owner, const FTransform& Transform, const FVector& Extent)
+{
+	FBallEliminationZone* Zone = Zones.FindByPredicate([Owner](const FBallEliminationZone& Existing) { return Existing.Owner == Owner; });
+	if (!Zone)
+	{
+		Zone = &Zones.AddDefaulted_GetRef();
+		Zone->Owner = Owner;
+	}
+
+	const FQuat Rotation = Transform.GetRotation();
+	Zone->Center     = FVector3f(Transform.GetLocation());
+	Zone->AxisX      = FVector3f(Rotation.GetAxisX());
+	Zone->AxisY      = FVector3f(Rotation.GetAxisY());
+	Zone->AxisZ      = FVector3f(Rotation.GetAxisZ());
+	Zone->BaseExtent = FVector3f(Extent.GetAbs());
+	Zone->Extent     = Zone->BaseExtent + FVector3f(BallRadius);
+
+	UE_LOG(LogBallGuys, Verbose, TEXT("Elimination zone registered: %s"), *GetNameSafe(Owner));
+}
+
+void UBallGuysEliminationSubsystem::UnregisterZone(const UObject* Owner)
+{
+	Zones.RemoveAllSwap([Owner](const FBallEliminationZone& Zone) { return Zone.Owner == Owner; });
+}
+
+void UBallGuysEliminationSubsystem::SetBallRadius(float Radius)
+{
+	if (Radius <= BallRadius)
+	{
+		return;
+	}
+
+	BallRadius = Radius;
+	for (FBallEliminationZone& Zone : Zones)
+	{
+		Zone.Extent = Zone.BaseExtent + FVector3f(BallRadius);
+	}
+}
+
+void UBallGuysEliminationSubsystem::FindBallsInZones(TConstArrayView<float> X, TConstArrayView<float> Y, TConstArrayView<float> Z, TArray<uint8>& OutInside) const
+{
+	const int32 NumBalls = X.Num();
+	check(Y.Num() == NumBalls && Z.Num() == NumBalls);
+
+	OutInside.SetNumZeroed(NumBalls, EAllowShrinking::No);
+	uint8* Inside = OutInside.GetData();
+	const float* PX = X.GetData();
+	const float* PY = Y.GetData();
+	const float* PZ = Z.GetData();
+
+	// Zones are few, balls are many: the inner loop is plain float math over the
+	// location arrays with no branches, which the compiler turns into SIMD
+	for (const FBallEliminationZone& Zone : Zones)
+	{
+		for (int32 Index = 0; Index < NumBalls; ++Index)
+		{
+			const float DX = PX[Index] - Zone.Center.X;
+			const float DY = PY[Index] - Zone.Center.Y;
+			const float DZ = PZ[Index] - Zone.Center.Z;
+
+			// Offset from the centre in the box's own axes
+			const float LX = DX * Zone.AxisX.X + DY * Zone.AxisX.Y + DZ * Zone.AxisX.Z;
+			const float LY = DX * Zone.AxisY.X + DY * Zone.AxisY.Y + DZ * Zone.AxisY.Z;
+			const float LZ = DX * Zone.AxisZ.X + DY * Zone.AxisZ.Y + DZ * Zone.AxisZ.Z;
+
+			Inside[Index] |= static_cast<uint8>(
+				(FMath::Abs(LX) <= Zone.Extent.X) & (FMath::Abs(LY) <= Zone.Extent.Y) & (FMath::Abs(LZ) <= Zone.Extent.Z));
+		}
+	}
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "BallGuysEliminationSubsystem.generated.h"
+
+/** An oriented box that eliminates any ball touching it: balls are tested by centre against the box grown by their radius. */
+struct FBallEliminationZone
+{
+	/** Whatever registered the zone; only compared, never dereferenced. */
+	const UObject* Owner = nullptr;
+
+	FVector3f Center = FVector3f::ZeroVector;
+
+	/** Unit box axes in world space, and the half size along each. */
+	FVector3f AxisX = FVector3f::ForwardVector;
+	FVector3f AxisY = FVector3f::RightVector;
+	FVector3f AxisZ = FVector3f::UpVector;
+	FVector3f Extent = FVector3f::ZeroVector;
+
+	/** Half size as registered; Extent is this plus the ball radius. */
+	FVector3f BaseExtent = FVector3f::ZeroVector;
+};
+
+/**
+ * Server: the world's elimination zones (kill volumes, out-of-bounds boxes).
+ * Zones don't collide or generate overlaps; instead UBallSimulationSubsystem hands every ball's
+ * location to FindBallsInZones once per step, which tests them all against each zone in one
+ * branch-free pass over flat arrays.
+ */
+UCLASS()
+class BALLGUYS_API UBallGuysEliminationSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Deinitialize() override;
+
+	/** Adds a zone, or moves Owner's zone if it already has one. Transform's scale is ignored: Extent is the world-space half size. */
+	void RegisterZone(const UObject* Owner, const FTransform& Transform, const FVector& Extent);
+	void UnregisterZone(const UObject* Owner);
+
+	/**
+	 * Grows every zone by Radius if it's the largest ball radius yet, so a ball counts as inside as soon as
+	 * any of it is, as with the sphere overlaps this replaces. Only the box's corners and edges are generous.
+	 */
+	void SetBallRadius(float Radius);
+
+	int32 GetNumZones() const { return Zones.Num(); }
+
+	/**
+	 * Sets OutInside[Index] to 1 for every ball whose location (X[Index], Y[Index], Z[Index]) is inside
+	 * any zone, 0 otherwise. The three arrays have one entry per ball.
+	 */
+	void FindBallsInZones(TConstArrayView<float> X, TConstArrayView<float> Y, TConstArrayView<float> Z, TArray<uint8>& OutInside) const;
+
+protected:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+private:
+	TArray<FBallEliminationZone> Zones;
+
+	float BallRadius = 0.f;
+};
@@ -0,0 +1,166 @@
+#include "BallGuysForceFieldSubsystem.h"
+#include "BallGuys.h"
+#include "Curves/CurveFloat.h"
+
+float FBallForceField::GetFalloff(float Alpha) const
+{
+	const float Position = FMath::Clamp(Alpha, 0.f, 1.f) * (FalloffSamples - 1);
+	const int32 Lower = FMath::Min(FMath::FloorToInt(Position), FalloffSamples - 2);
+	return FMath::Lerp(Falloff[Lower], Falloff[Lower + 1], Position - Lower);
+}
+
+bool UBallGuysForceFieldSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UBallGuysForceFieldSubsystem::Deinitialize()
+{
+	Fields.Reset();
+	Grid.Reset();
+
+	Super::Deinitialize();
+}
+
+FIntVector UBallGuysForceFieldSubsystem::GetCell(const FVector& Location)
+{
+	return FIntVector(
+		FMath::FloorToInt(Location.X / CellSize),
+		FMath::FloorToInt(Location.Y / CellSize),
+		FMath::FloorToInt(Location.Z / CellSize));
+}
+
+void UBallGuysForceFieldSubsystem::RegisterField(const UObject* Owner, EBallForceFieldType Type, float Strength, const FTransform& Transform, const FVector& Extent, const UCurveFloat* Falloff)
+{
+	FBallForceField* Field = Fields.FindByPredicate([Owner](const FBallForceField& Existing) { return Existing.Owner == Owner; });
+	if (!Field)
+	{
+		Field = &Fields.AddDefaulted_GetRef();
+		Field->Owner = Owner;
+	}
+
+	const FQuat Rotation = Transform.GetRotation();
+	Field->Type     = Type;
+	Field->Strength = Strength;
+	Field->Center   = FVector3f(Transform.GetLocation());
+	Field->AxisX    = FVector3f(Rotation.GetAxisX());
+	Field->AxisY    = FVector3f(Rotation.GetAxisY());
+	Field->AxisZ    = FVector3f(Rotation.GetAxisZ());
+	Field->Extent   = FVector3f(Extent.GetAbs());
+
+	// Baked once here rather than evaluating the curve for every ball every step
+	for (int32 Sample = 0; Sample < FBallForceField::FalloffSamples; ++Sample)
+	{
+		const float Alpha = static_cast<float>(Sample) / (FBallForceField::FalloffSamples - 1);
+		Field->Falloff[Sample] = Falloff ? Falloff->GetFloatValue(Alpha) : 1.f;
+	}
+
+	RebuildGrid();
+}
+
+void UBallGuysForceFieldSubsystem::UnregisterField(const UObject* Owner)
+{
+	if (Fields.RemoveAllSwap([Owner](const FBallForceField& Field) { return Field.Owner == Owner; }) > 0)
+	{
+		RebuildGrid();
+	}
+}
+
+void UBallGuysForceFieldSubsystem::RebuildGrid()
+{
+	Grid.Reset();
+
+	for (int32 Index = 0; Index < Fields.Num(); ++Index)
+	{
+		const FBallForceField& Field = Fields[Index];
+
+		// World bounds of the oriented box: each axis contributes its extent's projection
+		const FVector3f Half(
+			FMath::Abs(Field.AxisX.X) * Field.Extent.X + FMath::Abs(Field.AxisY.X) * Field.Extent.Y + FMath::Abs(Field.AxisZ.X) * Field.Extent.Z,
+			FMath::Abs(Field.AxisX.Y) * Field.Extent.X + FMath::Abs(Field.AxisY.Y) * Field.Extent.Y + FMath::Abs(Field.AxisZ.Y) * Field.Extent.Z,
+			FMath::Abs(Field.AxisX.Z) * Field.Extent.X + FMath::Abs(Field.AxisY.Z) * Field.Extent.Y + FMath::Abs(Field.AxisZ.Z) * Field.Extent.Z);
+
+		const FIntVector Min = GetCell(FVector(Field.Center - Half));
+		const FIntVector Max = GetCell(FVector(Field.Center + Half));
+		for (int32 X = Min.X; X <= Max.X; ++X)
+		{
+			for (int32 Y = Min.Y; Y <= Max.Y; ++Y)
+			{
+				for (int32 Z = Min.Z; Z <= Max.Z; ++Z)
+				{
+					Grid.FindOrAdd(FIntVector(X, Y, Z)).Add(Index);
+				}
+			}
+		}
+	}
+
+	UE_LOG(LogBallGuys, Verbose, TEXT("Force fields: %d fields over %d grid cells"), Fields.Num(), Grid.Num());
+}
+
+const TArray<int32>* UBallGuysForceFieldSubsystem::FindCandidates(const FVector& Location) const
+{
+	return Grid.Num() > 0 ? Grid.Find(GetCell(Location)) : nullptr;
+}
+
+bool UBallGuysForceFieldSubsystem::Evaluate(const TArray<int32>& Candidates, const FVector& Location, const FVector& Velocity, FVector& OutAcceleration, FVector& OutVelocityChange) const
+{
+	const FVector3f Point(Location);
+	FVector3f Acceleration = FVector3f::ZeroVector;
+	FVector3f VelocityChange = FVector3f::ZeroVector;
+	bool bInside = false;
+
+	for (const int32 Index : Candidates)
+	{
+		const FBallForceField& Field = Fields[Index];
+
+		// Offset from the centre in the field's own axes
+		const FVector3f Offset = Point - Field.Center;
+		const FVector3f Local(Offset | Field.AxisX, Offset | Field.AxisY, Offset | Field.AxisZ);
+		if (FMath::Abs(Local.X) > Field.Extent.X || FMath::Abs(Local.Y) > Field.Extent.Y || FMath::Abs(Local.Z) > Field.Extent.Z)
+		{
+			continue;
+		}
+		bInside = true;
+
+		switch (Field.Type)
+		{
+		case EBallForceFieldType::Directional:
+		{
+			// 0 where the wind comes in, 1 at the far side
+			const float Alpha = Field.Extent.X > 0.f ? (Local.X + Field.Extent.X) / (2.f * Field.Extent.X) : 0.f;
+			Acceleration += Field.AxisX * (Field.Strength * Field.GetFalloff(Alpha));
+			break;
+		}
+
+		case EBallForceFieldType::Radial:
+		{
+			const float Distance = Offset.Size();
+			if (Distance > UE_KINDA_SMALL_NUMBER)
+			{
+				const float Radius = FMath::Max(Field.Extent.GetMin(), 1.f);
+				Acceleration += (Offset / Distance) * (Field.Strength * Field.GetFalloff(Distance / Radius));
+			}
+			break;
+		}
+
+		case EBallForceFieldType::Launch:
+		{
+			// Falloff away from the pad's centre line
+			const float Radius = FMath::Max(FMath::Min(Field.Extent.X, Field.Extent.Y), 1.f);
+			const float Target = Field.Strength * Field.GetFalloff(FMath::Sqrt(Local.X * Local.X + Local.Y * Local.Y) / Radius);
+
+			// Only ever tops the speed up, so a ball that's already been launched isn't pushed again every step on its way out
+			const float Speed = FVector3f(Velocity) | Field.AxisZ;
+			if (Speed < Target)
+			{
+				VelocityChange += Field.AxisZ * (Target - Speed);
+			}
+			break;
+		}
+		}
+	}
+
+	OutAcceleration = FVector(Acceleration);
+	OutVelocityChange = FVector(VelocityChange);
+	return bInside;
+}
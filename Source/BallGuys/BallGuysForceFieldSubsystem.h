@@ -0,0 +1,92 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "BallGuysForceFieldSubsystem.generated.h"
+
+class UCurveFloat;
+
+UENUM(BlueprintType)
+enum class EBallForceFieldType : uint8
+{
+	/** Wind along the volume's X axis, fading from the side it blows in from to the far side. */
+	Directional,
+	/** Away from the volume's centre (towards it with a negative strength), fading outwards. */
+	Radial,
+	/** Jump pad: tops the ball's speed along the volume's Z axis up to the strength, so it launches the same however it arrives. */
+	Launch
+};
+
+/** One registered force field, baked for the per-step pass: no curve or actor is touched there. */
+struct FBallForceField
+{
+	/** Whatever registered the field; only compared, never dereferenced. */
+	const UObject* Owner = nullptr;
+
+	EBallForceFieldType Type = EBallForceFieldType::Directional;
+
+	/** Acceleration (cm/s^2) for Directional and Radial, launch speed (cm/s) for Launch. */
+	float Strength = 0.f;
+
+	FVector3f Center = FVector3f::ZeroVector;
+	FVector3f AxisX = FVector3f::ForwardVector;
+	FVector3f AxisY = FVector3f::RightVector;
+	FVector3f AxisZ = FVector3f::UpVector;
+	FVector3f Extent = FVector3f::ZeroVector;
+
+	/** The falloff curve sampled evenly over 0-1: from the side wind comes in (Directional), or out from the centre (Radial) or centre line (Launch). */
+	static constexpr int32 FalloffSamples = 16;
+	float Falloff[FalloffSamples] = {};
+
+	/** Falloff at Alpha (0-1), linearly between the samples. */
+	float GetFalloff(float Alpha) const;
+};
+
+/**
+ * The world's force fields (fans, blowers, jump pads), applied to balls by UBallSimulationSubsystem.
+ *
+ * Fields are indexed by a uniform grid over their bounds, so a ball only looks at its own grid cell:
+ * one hash lookup that finds nothing for a ball away from every field, and only the fields near it
+ * otherwise. Fields are registered on every machine, so a client's own predicted ball feels the same
+ * forces as the server's copy; kinematic balls (pooled, or interpolated on clients) are skipped.
+ */
+UCLASS()
+class BALLGUYS_API UBallGuysForceFieldSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Deinitialize() override;
+
+	/** Adds a field, or replaces Owner's. Transform's scale is ignored: Extent is the world-space half size. Falloff is full strength when null. */
+	void RegisterField(const UObject* Owner, EBallForceFieldType Type, float Strength, const FTransform& Transform, const FVector& Extent, const UCurveFloat* Falloff);
+	void UnregisterField(const UObject* Owner);
+
+	int32 GetNumFields() const { return Fields.Num(); }
+
+	/** Indices of the fields whose bounds share a grid cell with Location; null when there are none, which is the common case. */
+	const TArray<int32>* FindCandidates(const FVector& Location) const;
+
+	/**
+	 * Sums what the candidate fields containing Location do to a ball moving at Velocity: a continuous
+	 * acceleration and an instant velocity change. False if Location is inside none of them.
+	 */
+	bool Evaluate(const TArray<int32>& Candidates, const FVector& Location, const FVector& Velocity, FVector& OutAcceleration, FVector& OutVelocityChange) const;
+
+	/** Grid cell size (cm). About the size of a typical fan or pad, so most fields cover only a few cells. */
+	static constexpr float CellSize = 500.f;
+
+protected:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+private:
+	/** Contiguous, so the fields near a ball are read straight out of one allocation. */
+	TArray<FBallForceField> Fields;
+
+	/** Grid cell -> indices into Fields of everything whose bounds touch it. Rebuilt when fields change, which is rare. */
+	TMap<FIntVector, TArray<int32>> Grid;
+
+	void RebuildGrid();
+
+	static FIntVector GetCell(const FVector& Location);
+};
@@ -0,0 +1,42 @@
+#include "BallGuysForceVolume.h"
+#include "Components/BoxComponent.h"
+#include "Engine/World.h"
+
+ABallGuysForceVolume::ABallGuysForceVolume()
+{
+	PrimaryActorTick.bCanEverTick = false;
+
+	FieldBox = CreateDefaultSubobject<UBoxComponent>(TEXT("FieldBox"));
+	RootComponent = FieldBox;
+
+	// Only there to be placed and seen in the editor; balls are found by position
+	FieldBox->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+	FieldBox->SetCollisionResponseToAllChannels(ECollisionResponse::ECR_Ignore);
+	FieldBox->SetGenerateOverlapEvents(false);
+}
+
+void ABallGuysForceVolume::BeginPlay()
+{
+	Super::BeginPlay();
+
+	// Everywhere, not just the server: clients predict their own ball through it
+	RegisterField();
+}
+
+void ABallGuysForceVolume::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (UBallGuysForceFieldSubsystem* ForceFields = GetWorld()->GetSubsystem<UBallGuysForceFieldSubsystem>())
+	{
+		ForceFields->UnregisterField(this);
+	}
+
+	Super::EndPlay(EndPlayReason);
+}
+
+void ABallGuysForceVolume::RegisterField()
+{
+	if (UBallGuysForceFieldSubsystem* ForceFields = GetWorld()->GetSubsystem<UBallGuysForceFieldSubsystem>())
+	{
+		ForceFields->RegisterField(this, FieldType, Strength, FieldBox->GetComponentTransform(), FieldBox->GetScaledBoxExtent(), Falloff);
+	}
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Actor.h"
+#include "BallGuysForceFieldSubsystem.h"
+#include "BallGuysForceVolume.generated.h"
+
+class UBoxComponent;
+class UCurveFloat;
+
+/**
+ * A fan, blower or jump pad: pushes every ball whose centre is inside the box.
+ * Like ABallGuysKillVolume, the box doesn't collide or overlap anything; the field is registered
+ * with UBallGuysForceFieldSubsystem on every machine and applied in the ball simulation's pass.
+ * Volumes are expected to stay put; one that moves or changes has to call RegisterField again.
+ */
+UCLASS()
+class BALLGUYS_API ABallGuysForceVolume : public AActor
+{
+	GENERATED_BODY()
+	
+public:	
+	ABallGuysForceVolume();
+
+	/** Registers (or updates) this volume's field. */
+	UFUNCTION(BlueprintCallable, Category = "Force Field")
+	void RegisterField();
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Components")
+	UBoxComponent* FieldBox;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Force Field")
+	EBallForceFieldType FieldType = EBallForceFieldType::Directional;
+
+	/** Acceleration (cm/s^2) for Directional and Radial, launch speed (cm/s) for Launch. */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Force Field")
+	float Strength = 1500.f;
+
+	/** Strength multiplier over the field (0-1, see EBallForceFieldType). Full strength everywhere when unset. */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Force Field")
+	UCurveFloat* Falloff = nullptr;
+
+protected:
+	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+};
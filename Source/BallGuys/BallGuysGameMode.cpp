@@ -1,15 +1,19 @@
 #include "BallGuysGameMode.h"
+#include "BallGuys.h"
 #include "BallGuysGameState.h"
 #include "BallGuysPlayerState.h"
 #include "BallGuysPlayerController.h"
 #include "BallPawn.h"
+#include "BallGuysSpawnSubsystem.h"
 #include "BallGuysHUD.h"
+#include "MultiplayerSessionsSubsystem.h"
+#include "GameFramework/GameSession.h"
 #include "GameFramework/PlayerStart.h"
-#include "Kismet/GameplayStatics.h"
 
 ABallGuysGameMode::ABallGuysGameMode()
 {
-	PrimaryActorTick.bCanEverTick = true;
+	// Everything is driven by logins, ready changes and timers
+	PrimaryActorTick.bCanEverTick = false;
 	
 	// Set default classes
 	GameStateClass = ABallGuysGameState::StaticClass();
@@ -19,134 +23,170 @@ ABallGuysGameMode::ABallGuysGameMode()
 	DefaultPawnClass = ABallPawn::StaticClass();
 	HUDClass = ABallGuysHUD::StaticClass();
 
-	CountdownTimer = 0.0f;
-	GameTimer = GAME_DURATION;
 	bGameStarted = false;
-	bCountdownActive = false;
 }
 
 void ABallGuysGameMode::BeginPlay()
 {
 	Super::BeginPlay();
 
+	if (GetNetMode() == NM_DedicatedServer)
+	{
+		RegisterDedicatedSession();
+	}
+}
+
+void ABallGuysGameMode::InitGameState()
+{
+	Super::InitGameState();
+
 	BallGuysGameState = GetGameState<ABallGuysGameState>();
-	UpdateSpawnPoints();
 }
 
-void ABallGuysGameMode::Tick(float DeltaSeconds)
+void ABallGuysGameMode::RegisterDedicatedSession()
 {
-	Super::Tick(DeltaSeconds);
+	UGameInstance* GameInstance = GetGameInstance();
+	UMultiplayerSessionsSubsystem* Sessions = GameInstance ? GameInstance->GetSubsystem<UMultiplayerSessionsSubsystem>() : nullptr;
+
+	// The session survives map travel, so only the first map creates it
+	if (!Sessions || Sessions->HasActiveSession())
+	{
+		return;
+	}
 
-	HandleGameLoop();
+	const int32 MaxPlayers = GameSession ? GameSession->MaxPlayers : 16;
+	UE_LOG(LogBallGuys, Log, TEXT("Dedicated server: creating session (%d slots, %s)"), MaxPlayers, *DedicatedMatchType);
+	Sessions->CreateSession(MaxPlayers, DedicatedMatchType);
 }
 
 void ABallGuysGameMode::PostLogin(APlayerController* NewPlayer)
 {
 	Super::PostLogin(NewPlayer);
 
+	++NumPlayersLoggedIn;
+	if (const ABallGuysPlayerState* PS = NewPlayer ? NewPlayer->GetPlayerState<ABallGuysPlayerState>() : nullptr)
+	{
+		NumPlayersReady += PS->bIsReady ? 1 : 0;
+	}
+
 	// Respawn player at a random spawn point on join
 	RespawnPlayer(NewPlayer);
+
+	EvaluateReadyState();
 }
 
 void ABallGuysGameMode::Logout(AController* Exiting)
 {
+	// AI controllers (the benchmark's) log out too, but were never counted
+	if (const APlayerController* PC = Cast<APlayerController>(Exiting))
+	{
+		NumPlayersLoggedIn = FMath::Max(NumPlayersLoggedIn - 1, 0);
+		const ABallGuysPlayerState* PS = PC->GetPlayerState<ABallGuysPlayerState>();
+		if (PS && PS->bIsReady)
+		{
+			NumPlayersReady = FMath::Max(NumPlayersReady - 1, 0);
+		}
+	}
+
 	Super::Logout(Exiting);
+
+	EvaluateReadyState();
+}
+
+void ABallGuysGameMode::NotifyPlayerReadyChanged(ABallGuysPlayerState* PlayerState)
+{
+	if (!PlayerState)
+	{
+		return;
+	}
+
+	NumPlayersReady = FMath::Max(NumPlayersReady + (PlayerState->bIsReady ? 1 : -1), 0);
+	EvaluateReadyState();
 }
 
-void ABallGuysGameMode::HandleGameLoop()
+// ----------------- State machine -----------------
+
+EBallGuysGamePhase ABallGuysGameMode::GetPhase() const
 {
-	if (!BallGuysGameState) return;
+	return BallGuysGameState ? BallGuysGameState->CurrentGamePhase : EBallGuysGamePhase::WaitingForPlayers;
+}
 
-	int32 CurrentPlayerCount = GetNumPlayers();
+void ABallGuysGameMode::EvaluateReadyState()
+{
+	BALLGUYS_SCOPE(GameLoop);
 
-	// Waiting for players / Ready Logic
-	if (BallGuysGameState->CurrentGamePhase == EBallGuysGamePhase::WaitingForPlayers)
+	if (!BallGuysGameState)
 	{
-		if (CurrentPlayerCount >= MIN_PLAYERS_TO_START)
-		{
-			CheckReadyStatus();
-		}
-		else
-		{
-			// Reset countdown if players drop below min
-			bCountdownActive = false;
-			CountdownTimer = 0.0f;
-		}
+		return;
 	}
-	else if (BallGuysGameState->CurrentGamePhase == EBallGuysGamePhase::Countdown)
-	{
-		CountdownTimer -= GetWorld()->GetDeltaSeconds();
-		BallGuysGameState->TimeRemaining = CountdownTimer;
 
-		if (CountdownTimer <= 0.0f)
+	// Logic: If 2 players ready -> 10s countdown.
+	// If > 2 players and 2 are ready -> 20s countdown (simplified from prompt: "If 2 players are ready and there is more than 2 players in 20 seconds game will start regardless")
+	const bool bCanStart = NumPlayersLoggedIn >= MIN_PLAYERS_TO_START && NumPlayersReady >= 2;
+
+	switch (GetPhase())
+	{
+	case EBallGuysGamePhase::WaitingForPlayers:
+		if (bCanStart)
 		{
-			StartGame();
+			SetPhase(EBallGuysGamePhase::Countdown);
 		}
-	}
-	else if (BallGuysGameState->CurrentGamePhase == EBallGuysGamePhase::Playing)
-	{
-		GameTimer -= GetWorld()->GetDeltaSeconds();
-		BallGuysGameState->TimeRemaining = GameTimer;
+		break;
 
-		if (GameTimer <= 0.0f)
+	case EBallGuysGamePhase::Countdown:
+		// Reset countdown if players drop below min
+		if (NumPlayersLoggedIn < MIN_PLAYERS_TO_START)
 		{
-			EndGame();
+			SetPhase(EBallGuysGamePhase::WaitingForPlayers);
 		}
+		break;
+
+	default:
+		break;
 	}
 }
 
-void ABallGuysGameMode::CheckReadyStatus()
+void ABallGuysGameMode::SetPhase(EBallGuysGamePhase NewPhase)
 {
-	int32 ReadyCount = 0;
-	int32 TotalPlayers = 0;
+	BALLGUYS_SCOPE(GameLoop);
 
-	for (FConstPlayerControllerIterator It = GetWorld()->GetPlayerControllerIterator(); It; ++It)
+	if (!BallGuysGameState)
 	{
-		APlayerController* PC = It->Get();
-		if (PC)
-		{
-			TotalPlayers++;
-			ABallGuysPlayerState* PS = PC->GetPlayerState<ABallGuysPlayerState>();
-			if (PS && PS->bIsReady)
-			{
-				ReadyCount++;
-			}
-		}
+		return;
 	}
 
-	// Logic: If 2 players ready -> 10s countdown.
-	// If > 2 players and 2 are ready -> 20s countdown (simplified from prompt: "If 2 players are ready and there is more than 2 players in 20 seconds game will start regardless")
-	// Let's interpret: 
-	// 1. If 2 players are ready -> Start 10s timer? Or is it "Wait 10s then start"?
-	// 2. "If 2 players are ready and there is more than 2 players in 20 seconds game will start regardless" -> This implies a timeout.
-	
-	// Let's implement a simple logic:
-	// If All players ready -> Start immediately (or short countdown)
-	// If >= 2 players ready -> Start countdown if not already started.
-	
-	if (ReadyCount >= 2 && !bCountdownActive)
+	FTimerManager& TimerManager = GetWorldTimerManager();
+	TimerManager.ClearTimer(PhaseTimerHandle);
+
+	float PhaseDuration = 0.f;
+	switch (NewPhase)
 	{
-		bCountdownActive = true;
-		BallGuysGameState->SetGamePhase(EBallGuysGamePhase::Countdown);
-		
-		if (TotalPlayers > 2)
-		{
-			CountdownTimer = COUNTDOWN_DURATION_LONG;
-		}
-		else
-		{
-			CountdownTimer = COUNTDOWN_DURATION_SHORT;
-		}
+	case EBallGuysGamePhase::Countdown:
+		PhaseDuration = NumPlayersLoggedIn > 2 ? COUNTDOWN_DURATION_LONG : COUNTDOWN_DURATION_SHORT;
+		TimerManager.SetTimer(PhaseTimerHandle, this, &ABallGuysGameMode::StartGame, PhaseDuration, false);
+		break;
+
+	case EBallGuysGamePhase::Playing:
+		PhaseDuration = GAME_DURATION;
+		TimerManager.SetTimer(PhaseTimerHandle, this, &ABallGuysGameMode::EndGame, PhaseDuration, false);
+		break;
+
+	default:
+		break;
 	}
+
+	// Clients count the time down themselves from when the phase started
+	BallGuysGameState->SetGamePhase(NewPhase, PhaseDuration);
 }
 
 void ABallGuysGameMode::StartGame()
 {
 	bGameStarted = true;
-	bCountdownActive = false;
-	BallGuysGameState->SetGamePhase(EBallGuysGamePhase::Playing);
+	SetPhase(EBallGuysGamePhase::Playing);
 	
 	// Reset Lives and Respawn everyone?
+	TArray<APlayerController*> Players;
+	TArray<const AActor*> TheirBalls;
 	for (FConstPlayerControllerIterator It = GetWorld()->GetPlayerControllerIterator(); It; ++It)
 	{
 		APlayerController* PC = It->Get();
@@ -157,15 +197,27 @@ void ABallGuysGameMode::StartGame()
 			{
 				PS->ResetLives();
 			}
-			RespawnPlayer(PC);
+			Players.Add(PC);
+			TheirBalls.Add(PC->GetPawn());
 		}
 	}
+
+	// One pass for everyone, so nobody is placed on top of anyone else
+	TArray<APlayerStart*> Starts;
+	if (UBallGuysSpawnSubsystem* Spawns = GetWorld()->GetSubsystem<UBallGuysSpawnSubsystem>())
+	{
+		Spawns->ChooseSpawnPoints(Players.Num(), TheirBalls, Starts);
+	}
+	for (int32 Index = 0; Index < Players.Num(); ++Index)
+	{
+		RespawnPlayerAt(Players[Index], Starts.IsValidIndex(Index) ? Starts[Index] : nullptr);
+	}
 }
 
 void ABallGuysGameMode::EndGame()
 {
 	bGameStarted = false;
-	BallGuysGameState->SetGamePhase(EBallGuysGamePhase::GameOver);
+	SetPhase(EBallGuysGamePhase::GameOver);
 	// Show scoreboard logic handled by UI observing the state
 }
 
@@ -186,10 +238,7 @@ void ABallGuysGameMode::PlayerDied(AController* Controller)
 		{
 			// Player Eliminated
 			// Maybe move to spectator mode or just leave them dead
-			if (APawn* Pawn = Controller->GetPawn())
-			{
-				Pawn->Destroy();
-			}
+			ReleasePawn(Controller->GetPawn());
 		}
 	}
 }
@@ -198,32 +247,101 @@ void ABallGuysGameMode::RespawnPlayer(AController* Controller)
 {
 	if (!Controller) return;
 
-	// Destroy old pawn if exists
-	if (APawn* OldPawn = Controller->GetPawn())
-	{
-		OldPawn->Destroy();
-	}
+	UBallGuysSpawnSubsystem* Spawns = GetWorld()->GetSubsystem<UBallGuysSpawnSubsystem>();
+	RespawnPlayerAt(Controller, Spawns ? Spawns->ChooseSpawnPoint(Controller->GetPawn()) : nullptr);
+}
 
-	UpdateSpawnPoints();
+void ABallGuysGameMode::RespawnPlayerAt(AController* Controller, AActor* SpawnPoint)
+{
+	BALLGUYS_SCOPE(Respawn);
+	CSV_CUSTOM_STAT(BallGuys, Respawns, 1, ECsvCustomStatOp::Accumulate);
 
-	FVector SpawnLocation = FVector::ZeroVector;
-	FRotator SpawnRotation = FRotator::ZeroRotator;
+	if (!Controller) return;
 
-	if (SpawnPoints.Num() > 0)
+	// The player's own ball if it still has one, otherwise one from the pool
+	ABallPawn* Ball = Cast<ABallPawn>(Controller->GetPawn());
+	if (!Ball)
 	{
-		int32 RandomIndex = FMath::RandRange(0, SpawnPoints.Num() - 1);
-		AActor* SpawnPoint = SpawnPoints[RandomIndex];
+		if (APawn* OldPawn = Controller->GetPawn())
+		{
+			OldPawn->Destroy();
+		}
+		Ball = AcquirePooledPawn();
+	}
+
+	// Nothing to reuse: spawn one the usual way
+	if (!Ball || !SpawnPoint)
+	{
+		if (Ball)
+		{
+			ReleasePawn(Ball);
+		}
 		if (SpawnPoint)
 		{
-			SpawnLocation = SpawnPoint->GetActorLocation();
-			SpawnRotation = SpawnPoint->GetActorRotation();
+			RestartPlayerAtPlayerStart(Controller, SpawnPoint);
 		}
+		else
+		{
+			RestartPlayer(Controller);
+		}
+		return;
+	}
+
+	const FRotator SpawnRotation(0.f, SpawnPoint->GetActorRotation().Yaw, 0.f);
+	Ball->ResetForRespawn(FTransform(SpawnRotation, SpawnPoint->GetActorLocation()));
+
+	if (Controller->GetPawn() == Ball)
+	{
+		// Same ball, same possession; only the view needs turning to the spawn point
+		Controller->ClientSetRotation(SpawnRotation, true);
+	}
+	else
+	{
+		// Possesses, sets the view and calls the restart hooks, like a freshly spawned pawn gets
+		Controller->SetPawn(Ball);
+		FinishRestartPlayer(Controller, SpawnRotation);
+	}
+}
+
+void ABallGuysGameMode::ReleasePawn(APawn* Pawn)
+{
+	if (!IsValid(Pawn))
+	{
+		return;
 	}
 
-	RestartPlayerAtPlayerStart(Controller, SpawnPoints.Num() > 0 ? SpawnPoints[FMath::RandRange(0, SpawnPoints.Num() - 1)] : nullptr);
+	if (AController* Controller = Pawn->GetController())
+	{
+		Controller->UnPossess();
+	}
+
+	ABallPawn* Ball = Cast<ABallPawn>(Pawn);
+	if (!Ball || PawnPool.Num() >= MaxPooledPawns)
+	{
+		Pawn->Destroy();
+		return;
+	}
+
+	Ball->SetPooled(true);
+	PawnPool.Add(Ball);
+}
+
+ABallPawn* ABallGuysGameMode::AcquirePooledPawn()
+{
+	while (PawnPool.Num() > 0)
+	{
+		ABallPawn* Ball = PawnPool.Pop(EAllowShrinking::No);
+		if (IsValid(Ball))
+		{
+			return Ball;
+		}
+	}
+	return nullptr;
 }
 
-void ABallGuysGameMode::UpdateSpawnPoints()
+AActor* ABallGuysGameMode::ChoosePlayerStart_Implementation(AController* Player)
 {
-	UGameplayStatics::GetAllActorsOfClass(GetWorld(), APlayerStart::StaticClass(), SpawnPoints);
+	UBallGuysSpawnSubsystem* Spawns = GetWorld()->GetSubsystem<UBallGuysSpawnSubsystem>();
+	AActor* Start = Spawns ? Spawns->ChooseSpawnPoint(Player ? Player->GetPawn() : nullptr) : nullptr;
+	return Start ? Start : Super::ChoosePlayerStart_Implementation(Player);
 }
@@ -5,8 +5,14 @@
 #include "BallGuysGameState.h"
 #include "BallGuysGameMode.generated.h"
 
+class ABallPawn;
+
 /**
- * 
+ * Match flow as a state machine over EBallGuysGamePhase, driven by events rather than Tick:
+ * - WaitingForPlayers: re-evaluated only when a player joins, leaves or changes ready state
+ * - Countdown / Playing: end on a timer; a one-second timer keeps the replicated clock current
+ * - GameOver: stays until the next map
+ * Player and ready counts are kept up to date incrementally, so nothing iterates the players per frame.
  */
 UCLASS()
 class BALLGUYS_API ABallGuysGameMode : public AGameMode
@@ -16,31 +22,56 @@ class BALLGUYS_API ABallGuysGameMode : public AGameMode
 public:
 	ABallGuysGameMode();
 
-	virtual void Tick(float DeltaSeconds) override;
 	virtual void PostLogin(APlayerController* NewPlayer) override;
 	virtual void Logout(AController* Exiting) override;
 
 	// Game Loop Logic
-	void CheckReadyStatus();
 	void StartGame();
 	void EndGame();
-	void HandleGameLoop();
+
+	/** Called by ABallGuysPlayerState when its ready flag actually changes, on the server. */
+	void NotifyPlayerReadyChanged(class ABallGuysPlayerState* PlayerState);
 
 	// Player Management
 	void PlayerDied(AController* Controller);
 	void RespawnPlayer(AController* Controller);
 
+	/** RespawnPlayer at a given spawn point (null: let the engine pick). */
+	void RespawnPlayerAt(AController* Controller, AActor* SpawnPoint);
+
+	/** Takes Pawn out of play and keeps it for the next respawn; destroys it if it isn't a ball or the pool is full. */
+	void ReleasePawn(APawn* Pawn);
+
 protected:
 	virtual void BeginPlay() override;
 
+	/** The listen host logs in before BeginPlay, so the game state is picked up here. */
+	virtual void InitGameState() override;
+
+	/** First spawns go through the spawn registry as well, so joining players don't land on anyone. */
+	virtual AActor* ChoosePlayerStart_Implementation(AController* Player) override;
+
 	UPROPERTY()
 	ABallGuysGameState* BallGuysGameState;
 
-	// Timers
-	float CountdownTimer;
-	float GameTimer;
+	// ----------------- State machine -----------------
+
+	/** Leaves the current phase and enters NewPhase, scheduling whatever ends it. */
+	void SetPhase(EBallGuysGamePhase NewPhase);
+
+	EBallGuysGamePhase GetPhase() const;
+
+	/** WaitingForPlayers <-> Countdown, from the current counts. Only called when they change. */
+	void EvaluateReadyState();
+
+	/** Ends Countdown or Playing. */
+	FTimerHandle PhaseTimerHandle;
+
+	/** Player controllers logged in, and how many of their player states are ready. */
+	int32 NumPlayersLoggedIn = 0;
+	int32 NumPlayersReady = 0;
+
 	bool bGameStarted;
-	bool bCountdownActive;
 
 	// Config
 	const float COUNTDOWN_DURATION_SHORT = 10.0f;
@@ -48,7 +79,24 @@ protected:
 	const float GAME_DURATION = 300.0f; // 5 minutes
 	const int32 MIN_PLAYERS_TO_START = 2;
 
-	// Spawn Points
-	TArray<AActor*> SpawnPoints;
-	void UpdateSpawnPoints();
+	/** Match type a dedicated server advertises its session with. Clients filter on it. */
+	UPROPERTY(EditDefaultsOnly, Config, Category = "Session")
+	FString DedicatedMatchType = TEXT("FreeForAll");
+
+	/** Dedicated server only: creates the game session there's no host player to create. */
+	void RegisterDedicatedSession();
+
+	// ----------------- Pawn pool -----------------
+	// A death teleports the player's own ball back; eliminated and departed players' balls wait here, hidden.
+	// Saves a spawn, a channel open on every client and the GC of a four-component pawn per respawn.
+
+	UPROPERTY()
+	TArray<ABallPawn*> PawnPool;
+
+	/** Pooled balls beyond this are destroyed. */
+	UPROPERTY(EditDefaultsOnly, Category = "Pool")
+	int32 MaxPooledPawns = 16;
+
+	/** A pooled ball, or null if the pool is empty. */
+	ABallPawn* AcquirePooledPawn();
 };
@@ -1,30 +1,48 @@
 #include "BallGuysGameState.h"
+#include "BallGuysClockSubsystem.h"
 #include "Net/UnrealNetwork.h"
 
 ABallGuysGameState::ABallGuysGameState()
 {
-	TimeRemaining = 0.0f;
 	CurrentGamePhase = EBallGuysGamePhase::WaitingForPlayers;
+	PhaseStartServerTime = 0.0;
+	PhaseDuration = 0.0f;
 }
 
 void ABallGuysGameState::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
 {
 	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
 
-	DOREPLIFETIME(ABallGuysGameState, TimeRemaining);
 	DOREPLIFETIME(ABallGuysGameState, CurrentGamePhase);
+	DOREPLIFETIME(ABallGuysGameState, PhaseStartServerTime);
+	DOREPLIFETIME(ABallGuysGameState, PhaseDuration);
 }
 
-void ABallGuysGameState::SetGamePhase(EBallGuysGamePhase NewPhase)
+void ABallGuysGameState::SetGamePhase(EBallGuysGamePhase NewPhase, float Duration)
 {
 	if (HasAuthority())
 	{
 		CurrentGamePhase = NewPhase;
+		PhaseStartServerTime = UBallGuysClockSubsystem::GetServerTime(GetWorld());
+		PhaseDuration = Duration;
 	}
 }
 
+float ABallGuysGameState::GetTimeRemaining() const
+{
+	if (PhaseDuration <= 0.f)
+	{
+		return 0.f;
+	}
+
+	const double Elapsed = UBallGuysClockSubsystem::GetServerTime(GetWorld()) - PhaseStartServerTime;
+	return FMath::Clamp(static_cast<float>(PhaseDuration - Elapsed), 0.f, PhaseDuration);
+}
+
 FText ABallGuysGameState::GetFormattedTimeRemaining() const
 {
+	// Rounded up, so the countdown reads 00:01 until it's over rather than 00:00 for the last second
+	const float TimeRemaining = FMath::CeilToFloat(GetTimeRemaining());
 	int32 Minutes = FMath::FloorToInt(TimeRemaining / 60.0f);
 	int32 Seconds = FMath::FloorToInt(TimeRemaining) % 60;
 	return FText::FromString(FString::Printf(TEXT("%02d:%02d"), Minutes, Seconds));
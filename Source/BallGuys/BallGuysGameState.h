@@ -27,13 +27,22 @@ public:
 	virtual void GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const override;
 
 	UPROPERTY(Replicated, BlueprintReadOnly, Category = "BallGuys Gameplay")
-	float TimeRemaining;
+	EBallGuysGamePhase CurrentGamePhase;
 
+	/** Server time (UBallGuysClockSubsystem) the current phase started at, and how long it lasts; 0 if it lasts until something happens. */
 	UPROPERTY(Replicated, BlueprintReadOnly, Category = "BallGuys Gameplay")
-	EBallGuysGamePhase CurrentGamePhase;
+	double PhaseStartServerTime;
+
+	UPROPERTY(Replicated, BlueprintReadOnly, Category = "BallGuys Gameplay")
+	float PhaseDuration;
 
+	/** Enters NewPhase now, for Duration seconds. Replicates once per phase; clients work out the time left themselves. */
 	UFUNCTION(BlueprintCallable, Category = "BallGuys Gameplay")
-	void SetGamePhase(EBallGuysGamePhase NewPhase);
+	void SetGamePhase(EBallGuysGamePhase NewPhase, float Duration = 0.f);
+
+	/** Seconds left in the current phase, on the synchronized clock. */
+	UFUNCTION(BlueprintPure, Category = "BallGuys Gameplay")
+	float GetTimeRemaining() const;
 
 	UFUNCTION(BlueprintPure, Category = "BallGuys Gameplay")
 	FText GetFormattedTimeRemaining() const;
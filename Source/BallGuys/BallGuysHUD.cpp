@@ -1,5 +1,9 @@
 #include "BallGuysHUD.h"
+#include "BallGuysNetProfiler.h"
 #include "Blueprint/UserWidget.h"
+#include "Engine/Canvas.h"
+#include "Engine/Engine.h"
+#include "Engine/Font.h"
 
 ABallGuysHUD::ABallGuysHUD()
 {
@@ -18,3 +22,23 @@ void ABallGuysHUD::BeginPlay()
 		}
 	}
 }
+
+void ABallGuysHUD::DrawHUD()
+{
+	Super::DrawHUD();
+
+	// Replication summary for whoever started BallGuys.Net.Profile.Start (normally the listen host)
+	if (FBallGuysNetProfiler::IsActive() && Canvas)
+	{
+		TArray<FString> Lines;
+		FBallGuysNetProfiler::Get().GetSummary(Lines, 12);
+
+		UFont* Font = GEngine->GetSmallFont();
+		float Y = Canvas->ClipY * 0.25f;
+		for (const FString& Line : Lines)
+		{
+			DrawText(Line, FLinearColor::Yellow, 20.f, Y, Font);
+			Y += Font->GetMaxCharHeight() + 2.f;
+		}
+	}
+}
@@ -15,6 +15,8 @@ class BALLGUYS_API ABallGuysHUD : public AHUD
 public:
 	ABallGuysHUD();
 
+	virtual void DrawHUD() override;
+
 protected:
 	virtual void BeginPlay() override;
 
@@ -0,0 +1,78 @@
+#include "BallGuysHazardSubsystem.h"
+#include "BallGuys.h"
+#include "BallGuysClockSubsystem.h"
+#include "BallHazardComponent.h"
+#include "Engine/World.h"
+
+void FBallHazardTickFunction::ExecuteTick(float DeltaTime, ELevelTick TickType, ENamedThreads::Type CurrentThread, const FGraphEventRef& MyCompletionGraphEvent)
+{
+	if (Target && TickType != LEVELTICK_ViewportsOnly)
+	{
+		Target->Step();
+	}
+}
+
+FString FBallHazardTickFunction::DiagnosticMessage()
+{
+	return TEXT("FBallHazardTickFunction");
+}
+
+bool UBallGuysHazardSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UBallGuysHazardSubsystem::OnWorldBeginPlay(UWorld& InWorld)
+{
+	Super::OnWorldBeginPlay(InWorld);
+
+	TickFunction.Target = this;
+	TickFunction.bCanEverTick = true;
+	TickFunction.bStartWithTickEnabled = true;
+	TickFunction.TickGroup = TG_PrePhysics;
+	TickFunction.RegisterTickFunction(InWorld.PersistentLevel);
+}
+
+void UBallGuysHazardSubsystem::Deinitialize()
+{
+	if (TickFunction.IsTickFunctionRegistered())
+	{
+		TickFunction.UnRegisterTickFunction();
+	}
+	TickFunction.Target = nullptr;
+	Hazards.Reset();
+
+	Super::Deinitialize();
+}
+
+void UBallGuysHazardSubsystem::RegisterHazard(UBallHazardComponent* Hazard)
+{
+	Hazards.AddUnique(Hazard);
+}
+
+void UBallGuysHazardSubsystem::UnregisterHazard(UBallHazardComponent* Hazard)
+{
+	Hazards.RemoveSingleSwap(Hazard, EAllowShrinking::No);
+}
+
+void UBallGuysHazardSubsystem::Step()
+{
+	BALLGUYS_SCOPE(Hazards);
+
+	if (Hazards.Num() == 0)
+	{
+		return;
+	}
+
+	// One clock read for all of them, so hazards on the same schedule stay exactly in step
+	const double Now = UBallGuysClockSubsystem::GetServerTime(GetWorld());
+	for (UBallHazardComponent* Hazard : Hazards)
+	{
+		if (Hazard)
+		{
+			Hazard->UpdateTarget(Now);
+		}
+	}
+
+	CSV_CUSTOM_STAT(BallGuys, NumHazards, Hazards.Num(), ECsvCustomStatOp::Set);
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/EngineBaseTypes.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "BallGuysHazardSubsystem.generated.h"
+
+class UBallGuysHazardSubsystem;
+class UBallHazardComponent;
+
+/** Pre-physics tick for every hazard, so their kinematic targets are in the same frame's physics step as the balls. */
+USTRUCT()
+struct FBallHazardTickFunction : public FTickFunction
+{
+	GENERATED_BODY()
+
+	UBallGuysHazardSubsystem* Target = nullptr;
+
+	virtual void ExecuteTick(float DeltaTime, ELevelTick TickType, ENamedThreads::Type CurrentThread, const FGraphEventRef& MyCompletionGraphEvent) override;
+	virtual FString DiagnosticMessage() override;
+};
+
+template<>
+struct TStructOpsTypeTraits<FBallHazardTickFunction> : public TStructOpsTypeTraitsBase2<FBallHazardTickFunction>
+{
+	enum
+	{
+		WithCopy = false
+	};
+};
+
+/**
+ * Moves every UBallHazardComponent in the world to its pose at the current server time, in one pass.
+ * Runs the same on the server and on clients; hazards register themselves on BeginPlay.
+ */
+UCLASS()
+class BALLGUYS_API UBallGuysHazardSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void OnWorldBeginPlay(UWorld& InWorld) override;
+	virtual void Deinitialize() override;
+
+	void RegisterHazard(UBallHazardComponent* Hazard);
+	void UnregisterHazard(UBallHazardComponent* Hazard);
+
+	/** Called by the pre-physics tick function. */
+	void Step();
+
+protected:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+	FBallHazardTickFunction TickFunction;
+
+	UPROPERTY()
+	TArray<UBallHazardComponent*> Hazards;
+};
@@ -1,8 +1,7 @@
 #include "BallGuysKillVolume.h"
+#include "BallGuysEliminationSubsystem.h"
 #include "Components/BoxComponent.h"
-#include "BallGuysGameMode.h"
-#include "BallPawn.h"
-#include "Kismet/GameplayStatics.h"
+#include "Engine/World.h"
 
 ABallGuysKillVolume::ABallGuysKillVolume()
 {
@@ -11,9 +10,10 @@ ABallGuysKillVolume::ABallGuysKillVolume()
 	KillBox = CreateDefaultSubobject<UBoxComponent>(TEXT("KillBox"));
 	RootComponent = KillBox;
 
-	KillBox->SetCollisionEnabled(ECollisionEnabled::QueryOnly);
-	KillBox->SetCollisionObjectType(ECollisionChannel::ECC_WorldDynamic);
-	KillBox->SetCollisionResponseToAllChannels(ECollisionResponse::ECR_Overlap);
+	// Only there to be placed and seen in the editor; eliminations are checked by position
+	KillBox->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+	KillBox->SetCollisionResponseToAllChannels(ECollisionResponse::ECR_Ignore);
+	KillBox->SetGenerateOverlapEvents(false);
 }
 
 void ABallGuysKillVolume::BeginPlay()
@@ -22,25 +22,24 @@ void ABallGuysKillVolume::BeginPlay()
 	
 	if (HasAuthority())
 	{
-		KillBox->OnComponentBeginOverlap.AddDynamic(this, &ABallGuysKillVolume::OnOverlapBegin);
+		RegisterZone();
 	}
 }
 
-void ABallGuysKillVolume::OnOverlapBegin(UPrimitiveComponent* OverlappedComp, AActor* OtherActor, UPrimitiveComponent* OtherComp, int32 OtherBodyIndex, bool bFromSweep, const FHitResult& SweepResult)
+void ABallGuysKillVolume::EndPlay(const EEndPlayReason::Type EndPlayReason)
 {
-	if (OtherActor && (OtherActor != this))
+	if (UBallGuysEliminationSubsystem* Eliminations = GetWorld()->GetSubsystem<UBallGuysEliminationSubsystem>())
 	{
-		UE_LOG(LogTemp, Warning, TEXT("KillVolume Overlap with: %s"), *OtherActor->GetName());
+		Eliminations->UnregisterZone(this);
+	}
+
+	Super::EndPlay(EndPlayReason);
+}
 
-		ABallPawn* PlayerPawn = Cast<ABallPawn>(OtherActor);
-		if (PlayerPawn)
-		{
-			ABallGuysGameMode* GameMode = Cast<ABallGuysGameMode>(UGameplayStatics::GetGameMode(GetWorld()));
-			if (GameMode)
-			{
-				UE_LOG(LogTemp, Warning, TEXT("KillVolume killing pawn: %s"), *PlayerPawn->GetName());
-				GameMode->PlayerDied(PlayerPawn->GetController());
-			}
-		}
+void ABallGuysKillVolume::RegisterZone()
+{
+	if (UBallGuysEliminationSubsystem* Eliminations = GetWorld()->GetSubsystem<UBallGuysEliminationSubsystem>())
+	{
+		Eliminations->RegisterZone(this, KillBox->GetComponentTransform(), KillBox->GetScaledBoxExtent());
 	}
 }
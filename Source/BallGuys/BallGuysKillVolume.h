@@ -6,6 +6,12 @@
 
 class UBoxComponent;
 
+/**
+ * Eliminates any ball that touches the box.
+ * The box doesn't collide or overlap anything: on the server it's registered with
+ * UBallGuysEliminationSubsystem, which checks every ball against it each step.
+ * Volumes are expected to stay put; one that moves has to call RegisterZone again.
+ */
 UCLASS()
 class BALLGUYS_API ABallGuysKillVolume : public AActor
 {
@@ -14,14 +20,14 @@ class BALLGUYS_API ABallGuysKillVolume : public AActor
 public:	
 	ABallGuysKillVolume();
 
+	/** Registers (or updates) this volume's box with the elimination subsystem. Server only. */
+	void RegisterZone();
+
 protected:
 	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
 
 public:	
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Components")
 	UBoxComponent* KillBox;
-
-	UFUNCTION()
-	void OnOverlapBegin(UPrimitiveComponent* OverlappedComp, AActor* OtherActor, UPrimitiveComponent* OtherComp, int32 OtherBodyIndex, bool bFromSweep, const FHitResult& SweepResult);
-
 };
@@ -0,0 +1,425 @@
+#include "BallGuysNetProfiler.h"
+#include "BallGuys.h"
+#include "Engine/NetConnection.h"
+#include "Engine/NetDriver.h"
+#include "Engine/PackageMapClient.h"
+#include "Engine/World.h"
+#include "Components/ActorComponent.h"
+#include "GameFramework/Actor.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/DateTime.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "UObject/UnrealType.h"
+
+bool FBallGuysNetProfiler::bActive = false;
+bool FBallGuysNetProfiler::bMeasuring = false;
+
+FBallGuysNetProfiler& FBallGuysNetProfiler::Get()
+{
+	static FBallGuysNetProfiler Profiler;
+	return Profiler;
+}
+
+void FBallGuysNetProfiler::Start(UWorld* World, float InWindowSeconds)
+{
+	Stop();
+
+	UNetDriver* Driver = World ? World->GetNetDriver() : nullptr;
+	if (!Driver)
+	{
+		UE_LOG(LogBallGuys, Warning, TEXT("Net profile: no net driver in this world"));
+		return;
+	}
+
+	NetDriver = Driver;
+	WindowSeconds = FMath::Max(InWindowSeconds, 1.f);
+	WindowStartTime = FPlatformTime::Seconds();
+	Current.Reset();
+	LastWindow.Reset();
+	LastWindowSeconds = 0.0;
+	MeasureMap.Reset(NewObject<UBallGuysProfilerPackageMap>());
+	SentValues.Reset();
+
+#if !UE_BUILD_SHIPPING
+	Driver->SendRPCDel.BindRaw(this, &FBallGuysNetProfiler::OnSendRPC);
+#endif
+	PostActorTickHandle = FWorldDelegates::OnWorldPostActorTick.AddRaw(this, &FBallGuysNetProfiler::OnWorldPostActorTick);
+	TickerHandle = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateRaw(this, &FBallGuysNetProfiler::Tick));
+
+	bActive = true;
+	UE_LOG(LogBallGuys, Display, TEXT("Net profile: started, %.0fs windows"), WindowSeconds);
+}
+
+void FBallGuysNetProfiler::Stop()
+{
+	if (!bActive)
+	{
+		return;
+	}
+
+	FinishWindow();
+	bActive = false;
+
+#if !UE_BUILD_SHIPPING
+	if (UNetDriver* Driver = NetDriver.Get())
+	{
+		Driver->SendRPCDel.Unbind();
+	}
+#endif
+	NetDriver.Reset();
+	MeasureMap.Reset();
+	SentValues.Reset();
+	FWorldDelegates::OnWorldPostActorTick.Remove(PostActorTickHandle);
+	FTSTicker::GetCoreTicker().RemoveTicker(TickerHandle);
+
+	UE_LOG(LogBallGuys, Display, TEXT("Net profile: stopped"));
+}
+
+bool FBallGuysNetProfiler::Tick(float DeltaTime)
+{
+	if (!NetDriver.IsValid())
+	{
+		// World went away (map travel)
+		Stop();
+		return false;
+	}
+
+	if (FPlatformTime::Seconds() - WindowStartTime >= WindowSeconds)
+	{
+		FinishWindow();
+	}
+	return true;
+}
+
+void FBallGuysNetProfiler::FinishWindow()
+{
+	const double Now = FPlatformTime::Seconds();
+	LastWindowSeconds = FMath::Max(Now - WindowStartTime, 0.001);
+	LastWindow = MoveTemp(Current);
+	Current.Reset();
+	WindowStartTime = Now;
+
+	if (LastWindow.Num() > 0)
+	{
+		WriteCsv(LastWindow, LastWindowSeconds);
+	}
+}
+
+// ----------------- Recording -----------------
+
+FName FBallGuysNetProfiler::GetConnectionName(UNetConnection* Connection)
+{
+	return Connection ? FName(*Connection->LowLevelGetRemoteAddress(true)) : FName(TEXT("Unknown"));
+}
+
+void FBallGuysNetProfiler::Add(const FKey& Key, int64 Bits)
+{
+	FEntry& Entry = Current.FindOrAdd(Key);
+	Entry.Bits += Bits;
+	++Entry.Count;
+}
+
+void FBallGuysNetProfiler::RecordBunch(UNetConnection* Connection, const AActor* Actor, int64 Bits, bool bOpen)
+{
+	FKey Key;
+	Key.Connection = GetConnectionName(Connection);
+	Key.ActorClass = Actor ? Actor->GetClass()->GetFName() : FName(TEXT("None"));
+
+	if (!PendingRPC.IsNone() && PendingRPCActor.Get() == Actor)
+	{
+		Key.Item = PendingRPC;
+		Key.Kind = EKind::RPC;
+		Add(Key, Bits);
+		return;
+	}
+
+	int64 PropertyBits = 0;
+	if (Connection && Actor)
+	{
+		PropertyBits += RecordChangedProperties(Connection, Key, *Actor, *Actor, bOpen);
+		Actor->ForEachComponent(false, [&](const UActorComponent* Component)
+		{
+			if (Component->GetIsReplicated())
+			{
+				PropertyBits += RecordChangedProperties(Connection, Key, *Actor, *Component, bOpen);
+			}
+		});
+	}
+
+	Key.Item = TEXT("Overhead");
+	Key.Kind = EKind::Properties;
+	Add(Key, FMath::Max<int64>(Bits - PropertyBits, 0));
+}
+
+namespace BallGuysNetProfiler
+{
+	/** Whether a property with Condition goes to the connection at all; custom conditions are assumed to pass. */
+	bool IsSentTo(ELifetimeCondition Condition, bool bOwner, bool bOpen)
+	{
+		switch (Condition)
+		{
+		case COND_Never:
+		case COND_ReplayOnly:
+			return false;
+		case COND_InitialOnly:
+			return bOpen;
+		case COND_OwnerOnly:
+		case COND_AutonomousOnly:
+		case COND_ReplayOrOwner:
+			return bOwner;
+		case COND_InitialOrOwner:
+			return bOpen || bOwner;
+		case COND_SkipOwner:
+		case COND_SimulatedOnly:
+		case COND_SimulatedOnlyNoReplay:
+		case COND_SimulatedOrPhysics:
+		case COND_SimulatedOrPhysicsNoReplay:
+			return !bOwner;
+		default:
+			return true;
+		}
+	}
+}
+
+int64 FBallGuysNetProfiler::RecordChangedProperties(UNetConnection* Connection, const FKey& ActorKey, const AActor& Actor, const UObject& Object, bool bOpen)
+{
+	const UClass* Class = Object.GetClass();
+	TArray<FLifetimeProperty>* LifetimeProps = LifetimePropsByClass.Find(Class);
+	if (!LifetimeProps)
+	{
+		LifetimeProps = &LifetimePropsByClass.Add(Class);
+		Class->GetDefaultObject()->GetLifetimeReplicatedProps(*LifetimeProps);
+	}
+
+	MeasureMap->ConnectionMap = Cast<UPackageMapClient>(Connection->PackageMap);
+
+	TArray<FSentValue>& Sent = SentValues.FindOrAdd(TPair<FObjectKey, FObjectKey>(&Object, Connection));
+	if (bOpen || Sent.Num() != LifetimeProps->Num())
+	{
+		// A new channel starts from the archetype: only what differs from it is sent
+		Sent.Reset();
+		Sent.SetNum(LifetimeProps->Num());
+
+		const UObject* Archetype = Object.GetArchetype();
+		for (int32 Index = 0; Index < LifetimeProps->Num() && Archetype; ++Index)
+		{
+			const FRepRecord& Record = Class->ClassReps[(*LifetimeProps)[Index].RepIndex];
+
+			FBitWriter Writer(0, true);
+			MeasureProperty(Writer, Record.Property, Record.Property->ContainerPtrToValuePtr<void>(Archetype, Record.Index));
+			Sent[Index].Bytes = TArray<uint8>(Writer.GetData(), Writer.GetNumBytes());
+			Sent[Index].NumBits = Writer.GetNumBits();
+		}
+	}
+
+	const bool bOwner = Actor.GetNetConnection() == Connection;
+
+	FKey Key = ActorKey;
+	Key.Kind = EKind::Properties;
+
+	int64 TotalBits = 0;
+	for (int32 Index = 0; Index < LifetimeProps->Num(); ++Index)
+	{
+		const FLifetimeProperty& LifetimeProp = (*LifetimeProps)[Index];
+		if (!BallGuysNetProfiler::IsSentTo(LifetimeProp.Condition, bOwner, bOpen))
+		{
+			continue;
+		}
+
+		const FRepRecord& Record = Class->ClassReps[LifetimeProp.RepIndex];
+
+		FBitWriter Writer(0, true);
+		MeasureProperty(Writer, Record.Property, Record.Property->ContainerPtrToValuePtr<void>(&Object, Record.Index));
+
+		FSentValue& Value = Sent[Index];
+		if (Value.NumBits == Writer.GetNumBits() && FMemory::Memcmp(Value.Bytes.GetData(), Writer.GetData(), Writer.GetNumBytes()) == 0)
+		{
+			continue;
+		}
+		Value.Bytes = TArray<uint8>(Writer.GetData(), Writer.GetNumBytes());
+		Value.NumBits = Writer.GetNumBits();
+
+		// Components go under their owner's class, prefixed with their own
+		FString Item = &Object == &Actor ? Record.Property->GetName() : FString::Printf(TEXT("%s.%s"), *Class->GetName(), *Record.Property->GetName());
+		if (Record.Property->ArrayDim > 1)
+		{
+			Item += FString::Printf(TEXT("[%d]"), Record.Index);
+		}
+		Key.Item = FName(*Item);
+
+		Add(Key, Value.NumBits);
+		TotalBits += Value.NumBits;
+	}
+
+	MeasureMap->ConnectionMap = nullptr;
+	return TotalBits;
+}
+
+void FBallGuysNetProfiler::MeasureProperty(FBitWriter& Writer, const FProperty* Property, const void* Data) const
+{
+	if (const FArrayProperty* ArrayProperty = CastField<FArrayProperty>(Property))
+	{
+		FScriptArrayHelper Array(ArrayProperty, Data);
+		uint16 Num = static_cast<uint16>(Array.Num());
+		Writer << Num;
+		for (int32 Index = 0; Index < Array.Num(); ++Index)
+		{
+			MeasureProperty(Writer, ArrayProperty->Inner, Array.GetRawPtr(Index));
+		}
+		return;
+	}
+
+	const FStructProperty* StructProperty = CastField<FStructProperty>(Property);
+	if (StructProperty && !(StructProperty->Struct->StructFlags & STRUCT_NetSerializeNative))
+	{
+		for (TFieldIterator<FProperty> It(StructProperty->Struct); It; ++It)
+		{
+			if (It->HasAnyPropertyFlags(CPF_RepSkip))
+			{
+				continue;
+			}
+			for (int32 ArrayIndex = 0; ArrayIndex < It->ArrayDim; ++ArrayIndex)
+			{
+				MeasureProperty(Writer, *It, It->ContainerPtrToValuePtr<void>(Data, ArrayIndex));
+			}
+		}
+		return;
+	}
+
+	TGuardValue<bool> MeasuringGuard(bMeasuring, true);
+	Property->NetSerializeItem(Writer, MeasureMap.Get(), const_cast<void*>(Data));
+}
+
+void FBallGuysNetProfiler::RecordStruct(UPackageMap* Map, const TCHAR* OwnerClass, const TCHAR* StructName, int64 Bits)
+{
+	const UPackageMapClient* MapClient = Cast<UPackageMapClient>(Map);
+
+	FKey Key;
+	Key.Connection = GetConnectionName(MapClient ? MapClient->GetConnection() : nullptr);
+	Key.ActorClass = OwnerClass;
+	Key.Item = StructName;
+	Key.Kind = EKind::Struct;
+
+	Get().Add(Key, Bits);
+}
+
+#if !UE_BUILD_SHIPPING
+void FBallGuysNetProfiler::OnSendRPC(AActor* Actor, UFunction* Function, void* Parameters, FOutParmRec* OutParms, FFrame* Stack, UObject* SubObject, bool& bBlockSendRPC)
+{
+	PendingRPCActor = Actor;
+	PendingRPC = Function ? Function->GetFName() : NAME_None;
+}
+#endif
+
+void FBallGuysNetProfiler::OnWorldPostActorTick(UWorld* InWorld, ELevelTick TickType, float DeltaSeconds)
+{
+	// Property replication comes after this; nothing sent from here on belongs to an RPC
+	PendingRPCActor.Reset();
+	PendingRPC = NAME_None;
+}
+
+// ----------------- Output -----------------
+
+namespace BallGuysNetProfiler
+{
+	const TCHAR* KindToString(FBallGuysNetProfiler::EKind Kind)
+	{
+		switch (Kind)
+		{
+		case FBallGuysNetProfiler::EKind::RPC:    return TEXT("RPC");
+		case FBallGuysNetProfiler::EKind::Struct: return TEXT("Struct");
+		default:                                  return TEXT("Properties");
+		}
+	}
+}
+
+void FBallGuysNetProfiler::WriteCsv(const TMap<FKey, FEntry>& Window, double Seconds) const
+{
+	FString Csv = TEXT("Connection,ActorClass,Kind,Item,Bytes,Count,BytesPerSec\n");
+	for (const TPair<FKey, FEntry>& Pair : Window)
+	{
+		const double Bytes = Pair.Value.Bits / 8.0;
+		Csv += FString::Printf(TEXT("%s,%s,%s,%s,%.0f,%d,%.1f\n"),
+			*Pair.Key.Connection.ToString(), *Pair.Key.ActorClass.ToString(), BallGuysNetProfiler::KindToString(Pair.Key.Kind),
+			*Pair.Key.Item.ToString(), Bytes, Pair.Value.Count, Bytes / Seconds);
+	}
+
+	const FString Path = FPaths::ProfilingDir() / FString::Printf(TEXT("NetProfile-%s.csv"), *FDateTime::Now().ToString());
+	FFileHelper::SaveStringToFile(Csv, *Path);
+	UE_LOG(LogBallGuys, Display, TEXT("Net profile: wrote %s"), *Path);
+}
+
+void FBallGuysNetProfiler::GetSummary(TArray<FString>& OutLines, int32 MaxLines) const
+{
+	if (LastWindow.Num() == 0)
+	{
+		OutLines.Add(bActive ? FString::Printf(TEXT("Net profile: first %.0fs window running..."), WindowSeconds) : TEXT("Net profile: off"));
+		return;
+	}
+
+	// Sum over connections; the host wants to know what's expensive, then who it's expensive for
+	TMap<FKey, FEntry> ByItem;
+	TMap<FName, int64> ByConnection;
+	for (const TPair<FKey, FEntry>& Pair : LastWindow)
+	{
+		FKey Key = Pair.Key;
+		Key.Connection = NAME_None;
+		FEntry& Entry = ByItem.FindOrAdd(Key);
+		Entry.Bits += Pair.Value.Bits;
+		Entry.Count += Pair.Value.Count;
+
+		if (Pair.Key.Kind != EKind::Struct)
+		{
+			ByConnection.FindOrAdd(Pair.Key.Connection) += Pair.Value.Bits;
+		}
+	}
+
+	ByItem.ValueSort([](const FEntry& A, const FEntry& B) { return A.Bits > B.Bits; });
+	ByConnection.ValueSort([](const int64& A, const int64& B) { return A > B; });
+
+	int64 TotalBits = 0;
+	for (const TPair<FName, int64>& Pair : ByConnection)
+	{
+		TotalBits += Pair.Value;
+	}
+
+	OutLines.Add(FString::Printf(TEXT("Net profile (%.0fs): %.1f KB/s out over %d connection(s)"),
+		LastWindowSeconds, TotalBits / 8.0 / 1024.0 / LastWindowSeconds, ByConnection.Num()));
+
+	for (const TPair<FKey, FEntry>& Pair : ByItem)
+	{
+		if (OutLines.Num() > MaxLines)
+		{
+			break;
+		}
+		OutLines.Add(FString::Printf(TEXT("  %8.1f B/s  %-10s %s %s"),
+			Pair.Value.Bits / 8.0 / LastWindowSeconds, BallGuysNetProfiler::KindToString(Pair.Key.Kind),
+			*Pair.Key.ActorClass.ToString(), *Pair.Key.Item.ToString()));
+	}
+
+	if (ByConnection.Num() > 0)
+	{
+		const TPair<FName, int64>& Heaviest = *ByConnection.CreateConstIterator();
+		OutLines.Add(FString::Printf(TEXT("  heaviest connection %s: %.1f KB/s"), *Heaviest.Key.ToString(), Heaviest.Value / 8.0 / 1024.0 / LastWindowSeconds));
+	}
+}
+
+// ----------------- Console commands -----------------
+
+static FAutoConsoleCommandWithWorldAndArgs StartNetProfileCommand(
+	TEXT("BallGuys.Net.Profile.Start"),
+	TEXT("Starts attributing outgoing replication bytes to connection / actor class / property / RPC. Arg: window seconds (default 10). Each window is written to Saved/Profiling."),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		const float Window = Args.Num() > 0 ? FCString::Atof(*Args[0]) : 10.f;
+		FBallGuysNetProfiler::Get().Start(World, Window);
+	}));
+
+static FAutoConsoleCommand StopNetProfileCommand(
+	TEXT("BallGuys.Net.Profile.Stop"),
+	TEXT("Stops the replication bandwidth profiler and writes the current window."),
+	FConsoleCommandDelegate::CreateLambda([]()
+	{
+		FBallGuysNetProfiler::Get().Stop();
+	}));
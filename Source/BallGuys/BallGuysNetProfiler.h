@@ -0,0 +1,170 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "BallGuysProfilerPackageMap.h"
+#include "Containers/Ticker.h"
+#include "Engine/EngineBaseTypes.h"
+#include "Serialization/BitWriter.h"
+#include "UObject/CoreNet.h"
+#include "UObject/ObjectKey.h"
+#include "UObject/StrongObjectPtr.h"
+
+class AActor;
+class UFunction;
+class UNetConnection;
+class UNetDriver;
+class UPackageMap;
+class UWorld;
+struct FFrame;
+struct FOutParmRec;
+
+/**
+ * Replication bandwidth profiler: attributes outgoing bits per connection to actor class, property,
+ * RPC and our custom net-serialized structs, aggregated over a window.
+ * Every window is written to Saved/Profiling/NetProfile-<time>.csv and kept for the HUD summary.
+ *
+ *   BallGuys.Net.Profile.Start [WindowSeconds]   (default 10)
+ *   BallGuys.Net.Profile.Stop
+ *
+ * Sources:
+ * - Actor channel bunches (UBallGuysActorChannel::SendBunch): everything sent for an actor and its components.
+ * - Properties: FRepLayout doesn't say what each property wrote, so on every bunch each replicated property
+ *   of the actor and its replicated components is serialized the way the engine does it and compared with
+ *   what it serialized to at the last bunch on that connection (the archetype's, when the channel opens).
+ *   Changed ones whose condition lets them go to that connection are charged their size. The rest of the
+ *   bunch (handles, headers, spawn info) goes under "Overhead". An estimate: a changed push-model property
+ *   that wasn't marked dirty is charged although the engine held it back.
+ * - RPCs: a bunch sent for an actor while one of its RPCs is being processed is counted to that RPC
+ *   (hooked through UNetDriver::SendRPCDel, which Shipping doesn't have: there RPC bunches are Overhead).
+ *   Unreliable RPCs that get queued and sent with the next property update end up under Overhead.
+ * - Structs: bits written by our NetSerialize functions. A subset of the rows above, not extra.
+ *
+ * Game thread only. Outgoing only, from whichever side runs it (server: per client; client: its server connection).
+ */
+class BALLGUYS_API FBallGuysNetProfiler
+{
+public:
+	enum class EKind : uint8
+	{
+		Properties,
+		RPC,
+		Struct
+	};
+
+	struct FKey
+	{
+		FName Connection;
+		FName ActorClass;
+		FName Item;
+		EKind Kind = EKind::Properties;
+
+		bool operator==(const FKey& Other) const
+		{
+			return Connection == Other.Connection && ActorClass == Other.ActorClass && Item == Other.Item && Kind == Other.Kind;
+		}
+
+		friend uint32 GetTypeHash(const FKey& Key)
+		{
+			return HashCombine(HashCombine(GetTypeHash(Key.Connection), GetTypeHash(Key.ActorClass)), HashCombine(GetTypeHash(Key.Item), static_cast<uint32>(Key.Kind)));
+		}
+	};
+
+	struct FEntry
+	{
+		int64 Bits = 0;
+		int32 Count = 0;
+	};
+
+	static FBallGuysNetProfiler& Get();
+
+	/** Cheap check for the hooks, so nothing is looked up while profiling is off. */
+	static bool IsActive() { return bActive; }
+
+	void Start(UWorld* World, float InWindowSeconds);
+	void Stop();
+
+	/** Actor channel bunch for Actor, on Connection. bOpen: the channel's first, which sends every non-default property. */
+	void RecordBunch(UNetConnection* Connection, const AActor* Actor, int64 Bits, bool bOpen);
+
+	/**
+	 * Runs a NetSerialize body, Serialize(FArchive&), against Ar. While profiling a save it writes into a writer
+	 * of our own first and copies that into Ar, so the size is measured without assuming what Ar is.
+	 * Map tells us the connection.
+	 */
+	template<typename FuncType>
+	static void SerializeStruct(FArchive& Ar, UPackageMap* Map, const TCHAR* OwnerClass, const TCHAR* StructName, FuncType&& Serialize)
+	{
+		if (!bActive || bMeasuring || !Ar.IsSaving())
+		{
+			Serialize(Ar);
+			return;
+		}
+
+		FBitWriter Writer(0, true);
+		Serialize(Writer);
+		Ar.SerializeBits(Writer.GetData(), Writer.GetNumBits());
+		if (Writer.IsError())
+		{
+			Ar.SetError();
+		}
+
+		RecordStruct(Map, OwnerClass, StructName, Writer.GetNumBits());
+	}
+
+	/** Heaviest rows of the last finished window, summed over connections, as display lines. */
+	void GetSummary(TArray<FString>& OutLines, int32 MaxLines) const;
+
+private:
+	/** A property as it serialized at the last bunch on a connection. */
+	struct FSentValue
+	{
+		TArray<uint8> Bytes;
+		int64 NumBits = -1;
+	};
+
+	static void RecordStruct(UPackageMap* Map, const TCHAR* OwnerClass, const TCHAR* StructName, int64 Bits);
+
+	/** Records Object's properties that changed since the last bunch on Connection; returns their bits. */
+	int64 RecordChangedProperties(UNetConnection* Connection, const FKey& ActorKey, const AActor& Actor, const UObject& Object, bool bOpen);
+
+	/** Writes Data as FRepLayout would: natively net-serialized types directly, other structs and arrays element by element. */
+	void MeasureProperty(FBitWriter& Writer, const FProperty* Property, const void* Data) const;
+
+#if !UE_BUILD_SHIPPING
+	void OnSendRPC(AActor* Actor, UFunction* Function, void* Parameters, FOutParmRec* OutParms, FFrame* Stack, UObject* SubObject, bool& bBlockSendRPC);
+#endif
+	void OnWorldPostActorTick(UWorld* InWorld, ELevelTick TickType, float DeltaSeconds);
+	bool Tick(float DeltaTime);
+
+	void FinishWindow();
+	void WriteCsv(const TMap<FKey, FEntry>& Window, double Seconds) const;
+
+	static FName GetConnectionName(UNetConnection* Connection);
+	void Add(const FKey& Key, int64 Bits);
+
+	static bool bActive;
+
+	/** Set while properties are serialized for measuring, so our structs don't record themselves twice. */
+	static bool bMeasuring;
+
+	TWeakObjectPtr<UNetDriver> NetDriver;
+	float WindowSeconds = 10.f;
+	double WindowStartTime = 0.0;
+
+	TMap<FKey, FEntry> Current;
+	TMap<FKey, FEntry> LastWindow;
+	double LastWindowSeconds = 0.0;
+
+	/** RPC being sent right now, until the end of the frame's actor ticks. */
+	TWeakObjectPtr<const AActor> PendingRPCActor;
+	FName PendingRPC;
+
+	TStrongObjectPtr<UBallGuysProfilerPackageMap> MeasureMap;
+	TMap<const UClass*, TArray<FLifetimeProperty>> LifetimePropsByClass;
+
+	/** Per (object, connection), indexed like the class's lifetime properties. */
+	TMap<TPair<FObjectKey, FObjectKey>, TArray<FSentValue>> SentValues;
+
+	FTSTicker::FDelegateHandle TickerHandle;
+	FDelegateHandle PostActorTickHandle;
+};
@@ -1,5 +1,32 @@
 #include "BallGuysPlayerController.h"
+#include "BallGuysGameMode.h"
 #include "BallGuysPlayerState.h"
+#include "BallGuysBotComponent.h"
+#include "BallGuysClockSubsystem.h"
+
+void ABallGuysPlayerController::BeginPlay()
+{
+	Super::BeginPlay();
+
+	// Load testing: this client plays by itself
+	if (IsLocalController() && UBallGuysBotComponent::IsBotClient())
+	{
+		BotComponent = NewObject<UBallGuysBotComponent>(this, TEXT("BotComponent"));
+		BotComponent->RegisterComponent();
+	}
+}
+
+void ABallGuysPlayerController::PawnLeavingGame()
+{
+	ABallGuysGameMode* GameMode = GetWorld()->GetAuthGameMode<ABallGuysGameMode>();
+	if (GameMode && GetPawn())
+	{
+		GameMode->ReleasePawn(GetPawn());
+		return;
+	}
+
+	Super::PawnLeavingGame();
+}
 
 void ABallGuysPlayerController::ToggleReadyState()
 {
@@ -9,3 +36,16 @@ void ABallGuysPlayerController::ToggleReadyState()
 		PS->Server_SetIsReady(!PS->bIsReady);
 	}
 }
+
+void ABallGuysPlayerController::Server_RequestClockSync_Implementation(double ClientSendTime)
+{
+	Client_ClockSync(ClientSendTime, GetWorld()->GetTimeSeconds());
+}
+
+void ABallGuysPlayerController::Client_ClockSync_Implementation(double ClientSendTime, double ServerTime)
+{
+	if (UBallGuysClockSubsystem* Clock = GetWorld()->GetSubsystem<UBallGuysClockSubsystem>())
+	{
+		Clock->AddSample(ClientSendTime, ServerTime);
+	}
+}
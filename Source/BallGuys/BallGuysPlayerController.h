@@ -15,4 +15,21 @@ class BALLGUYS_API ABallGuysPlayerController : public APlayerController
 public:
 	UFUNCTION(BlueprintCallable, Category = "BallGuys Gameplay")
 	void ToggleReadyState();
+
+	/** Clock sync round trip, see UBallGuysClockSubsystem. ClientSendTime is the client's own clock, echoed back. */
+	UFUNCTION(Server, Unreliable)
+	void Server_RequestClockSync(double ClientSendTime);
+
+	UFUNCTION(Client, Unreliable)
+	void Client_ClockSync(double ClientSendTime, double ServerTime);
+
+protected:
+	virtual void BeginPlay() override;
+
+	/** Hands our ball to the game mode's pool instead of destroying it. */
+	virtual void PawnLeavingGame() override;
+
+	/** Only on clients started with -BallGuysBot. */
+	UPROPERTY()
+	class UBallGuysBotComponent* BotComponent;
 };
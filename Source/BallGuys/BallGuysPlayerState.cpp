@@ -1,4 +1,5 @@
 #include "BallGuysPlayerState.h"
+#include "BallGuysGameMode.h"
 #include "Net/UnrealNetwork.h"
 
 ABallGuysPlayerState::ABallGuysPlayerState()
@@ -44,5 +45,16 @@ void ABallGuysPlayerState::ResetLives()
 
 void ABallGuysPlayerState::Server_SetIsReady_Implementation(bool bReady)
 {
+	if (bIsReady == bReady)
+	{
+		return;
+	}
+
 	bIsReady = bReady;
+
+	// The game mode keeps a running ready count instead of polling every player state
+	if (ABallGuysGameMode* GameMode = GetWorld()->GetAuthGameMode<ABallGuysGameMode>())
+	{
+		GameMode->NotifyPlayerReadyChanged(this);
+	}
 }
@@ -0,0 +1,14 @@
+#include "BallGuysProfilerPackageMap.h"
+#include "Engine/PackageMapClient.h"
+
+bool UBallGuysProfilerPackageMap::SerializeObject(FArchive& Ar, UClass* InClass, UObject*& Obj, FNetworkGUID* OutNetGUID)
+{
+	FNetworkGUID NetGUID = ConnectionMap && Obj ? ConnectionMap->GetNetGUIDFromObject(Obj) : FNetworkGUID();
+	Ar << NetGUID;
+
+	if (OutNetGUID)
+	{
+		*OutNetGUID = NetGUID;
+	}
+	return true;
+}
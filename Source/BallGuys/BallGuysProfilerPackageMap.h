@@ -0,0 +1,25 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/CoreNet.h"
+#include "BallGuysProfilerPackageMap.generated.h"
+
+class UPackageMapClient;
+
+/**
+ * Package map FBallGuysNetProfiler serializes properties through to measure them. Object references are
+ * written as the NetGUID the connection already has for them, looked up but never assigned or exported,
+ * so measuring doesn't change what the connection sends.
+ */
+UCLASS(Transient)
+class BALLGUYS_API UBallGuysProfilerPackageMap : public UPackageMap
+{
+	GENERATED_BODY()
+
+public:
+	virtual bool SerializeObject(FArchive& Ar, UClass* InClass, UObject*& Obj, FNetworkGUID* OutNetGUID = nullptr) override;
+
+	/** Map of the connection being measured. Only read. */
+	UPROPERTY()
+	UPackageMapClient* ConnectionMap = nullptr;
+};
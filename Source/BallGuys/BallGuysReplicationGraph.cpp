@@ -0,0 +1,263 @@
+#include "BallGuysReplicationGraph.h"
+#include "BallPawn.h"
+#include "Engine/NetConnection.h"
+#include "GameFramework/GameStateBase.h"
+#include "GameFramework/PlayerState.h"
+
+// ----------------- Grid node -----------------
+
+UBallGuysReplicationGraphNode_Grid2D::UBallGuysReplicationGraphNode_Grid2D()
+{
+	bRequiresPrepareForReplicationCall = true;
+}
+
+void UBallGuysReplicationGraphNode_Grid2D::NotifyAddNetworkActor(const FNewReplicatedActorInfo& ActorInfo)
+{
+	Actors.Add(ActorInfo.Actor);
+}
+
+bool UBallGuysReplicationGraphNode_Grid2D::NotifyRemoveNetworkActor(const FNewReplicatedActorInfo& ActorInfo, bool bWarnIfNotFound)
+{
+	const bool bRemoved = Actors.RemoveSwap(ActorInfo.Actor, EAllowShrinking::No) > 0;
+
+	// The hash still points at it until the next rebuild
+	for (TPair<FIntPoint, TArray<FActorRepListType>>& Cell : Cells)
+	{
+		Cell.Value.RemoveSwap(ActorInfo.Actor, EAllowShrinking::No);
+	}
+
+	return bRemoved;
+}
+
+void UBallGuysReplicationGraphNode_Grid2D::NotifyResetAllNetworkActors()
+{
+	Actors.Reset();
+	Cells.Reset();
+}
+
+FIntPoint UBallGuysReplicationGraphNode_Grid2D::GetCell(const FVector& Location) const
+{
+	return FIntPoint(FMath::FloorToInt(Location.X / CellSize), FMath::FloorToInt(Location.Y / CellSize));
+}
+
+void UBallGuysReplicationGraphNode_Grid2D::PrepareForReplication()
+{
+	// O(actors) once per frame, so every connection's gather only touches nearby cells
+	for (TPair<FIntPoint, TArray<FActorRepListType>>& Cell : Cells)
+	{
+		Cell.Value.Reset();
+	}
+
+	for (const FActorRepListType& Actor : Actors)
+	{
+		Cells.FindOrAdd(GetCell(Actor->GetActorLocation())).Add(Actor);
+	}
+}
+
+void UBallGuysReplicationGraphNode_Grid2D::GatherActorListsForConnection(const FConnectionGatherActorListParameters& Params)
+{
+	NearList.Reset();
+	FarList.Reset();
+
+	const int32 CellRadius = FMath::CeilToInt(CullDistance / CellSize);
+	const float NearDistanceSq = FMath::Square(NearDistance);
+	const float CullDistanceSq = FMath::Square(CullDistance);
+	const bool bFarFrame = FarReplicationPeriod <= 1;
+
+	for (const FNetViewer& Viewer : Params.Viewers)
+	{
+		const FIntPoint ViewerCell = GetCell(Viewer.ViewLocation);
+
+		for (int32 X = ViewerCell.X - CellRadius; X <= ViewerCell.X + CellRadius; ++X)
+		{
+			for (int32 Y = ViewerCell.Y - CellRadius; Y <= ViewerCell.Y + CellRadius; ++Y)
+			{
+				const TArray<FActorRepListType>* Cell = Cells.Find(FIntPoint(X, Y));
+				if (!Cell)
+				{
+					continue;
+				}
+
+				for (const FActorRepListType& Actor : *Cell)
+				{
+					const float DistanceSq = FVector::DistSquared2D(Actor->GetActorLocation(), Viewer.ViewLocation);
+					if (DistanceSq <= NearDistanceSq)
+					{
+						NearList.Add(Actor);
+					}
+					else if (DistanceSq <= CullDistanceSq)
+					{
+						// Spread the far actors over the period instead of sending them all on the same frame
+						if (bFarFrame || (Params.ReplicationFrameNum + GetTypeHash(Actor)) % FarReplicationPeriod == 0)
+						{
+							FarList.Add(Actor);
+						}
+					}
+				}
+			}
+		}
+	}
+
+	if (NearList.Num() > 0)
+	{
+		Params.OutGatheredReplicationLists.AddReplicationActorList(NearList);
+	}
+	if (FarList.Num() > 0)
+	{
+		Params.OutGatheredReplicationLists.AddReplicationActorList(FarList);
+	}
+}
+
+// ----------------- Graph -----------------
+
+UBallGuysReplicationGraph::UBallGuysReplicationGraph()
+{
+}
+
+void UBallGuysReplicationGraph::InitGlobalActorClassSettings()
+{
+	Super::InitGlobalActorClassSettings();
+
+	// Balls: rate from the pawn's net update frequency, and keep far balls' channels open
+	// across the frames the grid skips them, otherwise they'd churn open/closed
+	const ABallPawn* BallCDO = GetDefault<ABallPawn>();
+
+	FClassReplicationInfo BallInfo;
+	BallInfo.ReplicationPeriodFrame = static_cast<uint8>(GetReplicationPeriodFrameForFrequency(BallCDO->GetNetUpdateFrequency()));
+	BallInfo.SetCullDistanceSquared(FMath::Square(CullDistance));
+	BallInfo.ActorChannelFrameTimeout = static_cast<uint8>(FMath::Clamp<int32>(FarReplicationPeriod * 2, BallInfo.ActorChannelFrameTimeout, MAX_uint8));
+	GlobalActorReplicationInfoMap.SetClassInfo(ABallPawn::StaticClass(), BallInfo);
+}
+
+void UBallGuysReplicationGraph::InitGlobalGraphNodes()
+{
+	GridNode = CreateNewNode<UBallGuysReplicationGraphNode_Grid2D>();
+	GridNode->CellSize = GridCellSize;
+	GridNode->NearDistance = NearDistance;
+	GridNode->CullDistance = CullDistance;
+	GridNode->FarReplicationPeriod = FMath::Max(FarReplicationPeriod, 1);
+	AddGlobalGraphNode(GridNode);
+
+	AlwaysRelevantNode = CreateNewNode<UReplicationGraphNode_ActorList>();
+	AddGlobalGraphNode(AlwaysRelevantNode);
+
+	PlayerStateNode = CreateNewNode<UReplicationGraphNode_PlayerStateFrequencyLimiter>();
+	AddGlobalGraphNode(PlayerStateNode);
+}
+
+void UBallGuysReplicationGraph::InitConnectionGraphNodes(UNetReplicationGraphConnection* RepGraphConnection)
+{
+	Super::InitConnectionGraphNodes(RepGraphConnection);
+
+	UReplicationGraphNode_AlwaysRelevant_ForConnection* OwnerNode = CreateNewNode<UReplicationGraphNode_AlwaysRelevant_ForConnection>();
+	AddConnectionGraphNode(OwnerNode, RepGraphConnection);
+	OwnerNodes.Add(RepGraphConnection->NetConnection, OwnerNode);
+}
+
+void UBallGuysReplicationGraph::RemoveClientConnection(UNetConnection* NetConnection)
+{
+	OwnerNodes.Remove(NetConnection);
+
+	Super::RemoveClientConnection(NetConnection);
+}
+
+void UBallGuysReplicationGraph::ResetGameWorldState()
+{
+	Super::ResetGameWorldState();
+
+	ActorsWithoutNetConnection.Reset();
+}
+
+UBallGuysReplicationGraph::ERouting UBallGuysReplicationGraph::GetRouting(const AActor* Actor) const
+{
+	if (Actor->IsA<APlayerState>())
+	{
+		return ERouting::PlayerState;
+	}
+	if (Actor->IsA<AGameStateBase>() || Actor->bAlwaysRelevant)
+	{
+		return ERouting::AlwaysRelevant;
+	}
+	if (Actor->bOnlyRelevantToOwner)
+	{
+		return ERouting::RelevantToOwner;
+	}
+	return ERouting::Spatialize;
+}
+
+UReplicationGraphNode_AlwaysRelevant_ForConnection* UBallGuysReplicationGraph::GetOwnerNode(UNetConnection* Connection) const
+{
+	UReplicationGraphNode_AlwaysRelevant_ForConnection* const* Node = OwnerNodes.Find(Connection);
+	return Node ? *Node : nullptr;
+}
+
+void UBallGuysReplicationGraph::RouteAddNetworkActorToNodes(const FNewReplicatedActorInfo& ActorInfo, FGlobalActorReplicationInfo& GlobalInfo)
+{
+	switch (GetRouting(ActorInfo.Actor))
+	{
+	case ERouting::PlayerState:
+		// The limiter node picks player states up from the world itself
+		break;
+	case ERouting::AlwaysRelevant:
+		AlwaysRelevantNode->NotifyAddNetworkActor(ActorInfo);
+		break;
+	case ERouting::RelevantToOwner:
+		ActorsWithoutNetConnection.Add(ActorInfo.Actor);
+		break;
+	case ERouting::Spatialize:
+		GridNode->NotifyAddNetworkActor(ActorInfo);
+		break;
+	}
+}
+
+void UBallGuysReplicationGraph::RouteRemoveNetworkActorToNodes(const FNewReplicatedActorInfo& ActorInfo)
+{
+	switch (GetRouting(ActorInfo.Actor))
+	{
+	case ERouting::PlayerState:
+		break;
+	case ERouting::AlwaysRelevant:
+		AlwaysRelevantNode->NotifyRemoveNetworkActor(ActorInfo);
+		break;
+	case ERouting::RelevantToOwner:
+		ActorsWithoutNetConnection.RemoveSwap(ActorInfo.Actor);
+		if (UReplicationGraphNode_AlwaysRelevant_ForConnection* OwnerNode = GetOwnerNode(ActorInfo.Actor->GetNetConnection()))
+		{
+			OwnerNode->NotifyRemoveNetworkActor(ActorInfo, false);
+		}
+		break;
+	case ERouting::Spatialize:
+		GridNode->NotifyRemoveNetworkActor(ActorInfo);
+		break;
+	}
+}
+
+int32 UBallGuysReplicationGraph::ServerReplicateActors(float DeltaSeconds)
+{
+	// Owner-only actors get routed to their connection's node as soon as they have one
+	for (int32 Index = ActorsWithoutNetConnection.Num() - 1; Index >= 0; --Index)
+	{
+		AActor* Actor = ActorsWithoutNetConnection[Index];
+		bool bRouted = !IsValid(Actor);
+
+		if (!bRouted)
+		{
+			if (UReplicationGraphNode_AlwaysRelevant_ForConnection* OwnerNode = GetOwnerNode(Actor->GetNetConnection()))
+			{
+				OwnerNode->NotifyAddNetworkActor(FNewReplicatedActorInfo(Actor));
+				bRouted = true;
+			}
+		}
+
+		if (bRouted)
+		{
+			ActorsWithoutNetConnection.RemoveAtSwap(Index, 1, EAllowShrinking::No);
+		}
+	}
+
+	const double StartTime = FPlatformTime::Seconds();
+	const int32 NumReplicated = Super::ServerReplicateActors(DeltaSeconds);
+	LastReplicateActorsSeconds = FPlatformTime::Seconds() - StartTime;
+
+	return NumReplicated;
+}
@@ -0,0 +1,116 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ReplicationGraph.h"
+#include "BallGuysReplicationGraph.generated.h"
+
+/**
+ * Spatial hash of actors on the XY plane, rebuilt once per replication frame.
+ * Each connection only looks at the cells around its viewer; actors past NearDistance
+ * are only handed out every FarReplicationPeriod frames, and actors past CullDistance not at all.
+ */
+UCLASS()
+class BALLGUYS_API UBallGuysReplicationGraphNode_Grid2D : public UReplicationGraphNode
+{
+	GENERATED_BODY()
+
+public:
+	UBallGuysReplicationGraphNode_Grid2D();
+
+	virtual void NotifyAddNetworkActor(const FNewReplicatedActorInfo& ActorInfo) override;
+	virtual bool NotifyRemoveNetworkActor(const FNewReplicatedActorInfo& ActorInfo, bool bWarnIfNotFound = true) override;
+	virtual void NotifyResetAllNetworkActors() override;
+	virtual void PrepareForReplication() override;
+	virtual void GatherActorListsForConnection(const FConnectionGatherActorListParameters& Params) override;
+
+	float CellSize = 5000.f;
+	float NearDistance = 5000.f;
+	float CullDistance = 20000.f;
+	uint32 FarReplicationPeriod = 3;
+
+private:
+	FIntPoint GetCell(const FVector& Location) const;
+
+	TArray<FActorRepListType> Actors;
+	TMap<FIntPoint, TArray<FActorRepListType>> Cells;
+
+	// Scratch lists, refilled per connection. The graph gathers and replicates one connection at a time.
+	FActorRepListRefView NearList;
+	FActorRepListRefView FarList;
+};
+
+/**
+ * Replication graph for BallGuys lobbies.
+ * - Balls and other spatial actors go through UBallGuysReplicationGraphNode_Grid2D
+ * - The game state and other always-relevant actors go in one global list
+ * - Player states go through the engine's player state frequency limiter
+ * - Owner-only actors (player controllers) go in a per-connection list
+ */
+UCLASS(Transient, Config = Engine)
+class BALLGUYS_API UBallGuysReplicationGraph : public UReplicationGraph
+{
+	GENERATED_BODY()
+
+public:
+	UBallGuysReplicationGraph();
+
+	virtual void InitGlobalActorClassSettings() override;
+	virtual void InitGlobalGraphNodes() override;
+	virtual void InitConnectionGraphNodes(UNetReplicationGraphConnection* RepGraphConnection) override;
+	virtual void RouteAddNetworkActorToNodes(const FNewReplicatedActorInfo& ActorInfo, FGlobalActorReplicationInfo& GlobalInfo) override;
+	virtual void RouteRemoveNetworkActorToNodes(const FNewReplicatedActorInfo& ActorInfo) override;
+	virtual void RemoveClientConnection(UNetConnection* NetConnection) override;
+	virtual void ResetGameWorldState() override;
+	virtual int32 ServerReplicateActors(float DeltaSeconds) override;
+
+	/** Size (cm) of one grid cell. Roughly the near distance works well. */
+	UPROPERTY(Config)
+	float GridCellSize = 5000.f;
+
+	/** Within this distance (cm) of a viewer, balls replicate at their full rate. */
+	UPROPERTY(Config)
+	float NearDistance = 5000.f;
+
+	/** Past this distance (cm) from a viewer, balls aren't replicated to it at all. */
+	UPROPERTY(Config)
+	float CullDistance = 20000.f;
+
+	/** Between NearDistance and CullDistance, balls replicate only every this many frames. */
+	UPROPERTY(Config)
+	int32 FarReplicationPeriod = 3;
+
+	/** Wall time of the last ServerReplicateActors, for the benchmark. */
+	double GetLastReplicateActorsSeconds() const { return LastReplicateActorsSeconds; }
+
+	UPROPERTY()
+	UBallGuysReplicationGraphNode_Grid2D* GridNode;
+
+	UPROPERTY()
+	UReplicationGraphNode_ActorList* AlwaysRelevantNode;
+
+	UPROPERTY()
+	UReplicationGraphNode_PlayerStateFrequencyLimiter* PlayerStateNode;
+
+private:
+	enum class ERouting : uint8
+	{
+		Spatialize,
+		AlwaysRelevant,
+		RelevantToOwner,
+		PlayerState,
+	};
+
+	ERouting GetRouting(const AActor* Actor) const;
+
+	double LastReplicateActorsSeconds = 0.0;
+
+	UReplicationGraphNode_AlwaysRelevant_ForConnection* GetOwnerNode(UNetConnection* Connection) const;
+
+	/** One owner-only node per connection. */
+	UPROPERTY()
+	TMap<UNetConnection*, UReplicationGraphNode_AlwaysRelevant_ForConnection*> OwnerNodes;
+
+	/** Owner-only actors that don't have a connection yet; routed in ServerReplicateActors once they do. */
+	UPROPERTY()
+	TArray<AActor*> ActorsWithoutNetConnection;
+};
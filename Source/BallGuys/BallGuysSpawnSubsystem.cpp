@@ -0,0 +1,209 @@
+#include "BallGuysSpawnSubsystem.h"
+#include "BallGuys.h"
+#include "BallSimulationSubsystem.h"
+#include "Engine/Level.h"
+#include "Engine/World.h"
+#include "EngineUtils.h"
+#include "GameFramework/PlayerStart.h"
+
+// ----------------- Occupancy -----------------
+
+FBallSpawnOccupancy::FBallSpawnOccupancy(float InClearance)
+	: Clearance(FMath::Max(InClearance, 1.f))
+{
+}
+
+FIntVector FBallSpawnOccupancy::GetCell(const FVector& Location) const
+{
+	return FIntVector(
+		FMath::FloorToInt(Location.X / Clearance),
+		FMath::FloorToInt(Location.Y / Clearance),
+		FMath::FloorToInt(Location.Z / Clearance));
+}
+
+void FBallSpawnOccupancy::Add(const FVector& Location)
+{
+	Cells.FindOrAdd(GetCell(Location)).Add(Location);
+}
+
+bool FBallSpawnOccupancy::IsClear(const FVector& Location) const
+{
+	const FIntVector Center = GetCell(Location);
+	const float ClearanceSquared = FMath::Square(Clearance);
+
+	for (int32 X = -1; X <= 1; ++X)
+	{
+		for (int32 Y = -1; Y <= 1; ++Y)
+		{
+			for (int32 Z = -1; Z <= 1; ++Z)
+			{
+				const TArray<FVector, TInlineAllocator<2>>* Cell = Cells.Find(Center + FIntVector(X, Y, Z));
+				if (!Cell)
+				{
+					continue;
+				}
+				for (const FVector& Other : *Cell)
+				{
+					if (FVector::DistSquared(Other, Location) < ClearanceSquared)
+					{
+						return false;
+					}
+				}
+			}
+		}
+	}
+	return true;
+}
+
+// ----------------- Registry -----------------
+
+bool UBallGuysSpawnSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UBallGuysSpawnSubsystem::OnWorldBeginPlay(UWorld& InWorld)
+{
+	Super::OnWorldBeginPlay(InWorld);
+
+	LevelAddedHandle   = FWorldDelegates::LevelAddedToWorld.AddUObject(this, &UBallGuysSpawnSubsystem::OnLevelAdded);
+	LevelRemovedHandle = FWorldDelegates::LevelRemovedFromWorld.AddUObject(this, &UBallGuysSpawnSubsystem::OnLevelRemoved);
+
+	Build();
+}
+
+void UBallGuysSpawnSubsystem::Deinitialize()
+{
+	FWorldDelegates::LevelAddedToWorld.Remove(LevelAddedHandle);
+	FWorldDelegates::LevelRemovedFromWorld.Remove(LevelRemovedHandle);
+	SpawnPoints.Reset();
+
+	Super::Deinitialize();
+}
+
+void UBallGuysSpawnSubsystem::Build()
+{
+	SpawnPoints.Reset();
+	for (TActorIterator<APlayerStart> It(GetWorld()); It; ++It)
+	{
+		SpawnPoints.Add(*It);
+	}
+	bBuilt = true;
+
+	UE_LOG(LogBallGuys, Log, TEXT("Spawn registry: %d spawn points"), SpawnPoints.Num());
+}
+
+void UBallGuysSpawnSubsystem::AddLevel(ULevel* Level)
+{
+	for (AActor* Actor : Level->Actors)
+	{
+		if (APlayerStart* Start = Cast<APlayerStart>(Actor))
+		{
+			SpawnPoints.AddUnique(Start);
+		}
+	}
+}
+
+void UBallGuysSpawnSubsystem::OnLevelAdded(ULevel* Level, UWorld* InWorld)
+{
+	if (InWorld == GetWorld() && Level && bBuilt)
+	{
+		AddLevel(Level);
+	}
+}
+
+void UBallGuysSpawnSubsystem::OnLevelRemoved(ULevel* Level, UWorld* InWorld)
+{
+	// A null level means every streaming level went away
+	if (InWorld != GetWorld())
+	{
+		return;
+	}
+
+	SpawnPoints.RemoveAll([Level](const APlayerStart* Start)
+	{
+		return !IsValid(Start) || !Level || Start->GetLevel() == Level;
+	});
+}
+
+FBallSpawnOccupancy UBallGuysSpawnSubsystem::BuildOccupancy(TConstArrayView<const AActor*> Ignore) const
+{
+	FBallSpawnOccupancy Occupancy(SpawnClearance);
+
+	if (const UBallSimulationSubsystem* Simulation = GetWorld()->GetSubsystem<UBallSimulationSubsystem>())
+	{
+		TArray<FVector> Locations;
+		Simulation->GetBallLocationsInPlay(Locations, Ignore);
+		for (const FVector& Location : Locations)
+		{
+			Occupancy.Add(Location);
+		}
+	}
+	return Occupancy;
+}
+
+int32 UBallGuysSpawnSubsystem::FindClearSpawnPoint(const FBallSpawnOccupancy& Occupancy, const TBitArray<>& Taken) const
+{
+	const int32 Num = SpawnPoints.Num();
+	const int32 First = FMath::RandRange(0, Num - 1);
+
+	for (int32 Offset = 0; Offset < Num; ++Offset)
+	{
+		const int32 Index = (First + Offset) % Num;
+		const APlayerStart* Start = SpawnPoints[Index];
+		if (!Taken[Index] && IsValid(Start) && Occupancy.IsClear(Start->GetActorLocation()))
+		{
+			return Index;
+		}
+	}
+	return INDEX_NONE;
+}
+
+APlayerStart* UBallGuysSpawnSubsystem::ChooseSpawnPoint(const AActor* Ignore)
+{
+	TArray<APlayerStart*> Chosen;
+	TArray<const AActor*> IgnoreList;
+	if (Ignore)
+	{
+		IgnoreList.Add(Ignore);
+	}
+
+	ChooseSpawnPoints(1, IgnoreList, Chosen);
+	return Chosen.Num() > 0 ? Chosen[0] : nullptr;
+}
+
+void UBallGuysSpawnSubsystem::ChooseSpawnPoints(int32 NumPlayers, const TArray<const AActor*>& Ignore, TArray<APlayerStart*>& OutSpawnPoints)
+{
+	OutSpawnPoints.Reset(NumPlayers);
+
+	// A player can log in before play begins
+	if (!bBuilt)
+	{
+		Build();
+	}
+
+	SpawnPoints.RemoveAll([](const APlayerStart* Start) { return !IsValid(Start); });
+	if (SpawnPoints.Num() == 0)
+	{
+		return;
+	}
+
+	// Every pick is added to the occupancy, so later picks keep clear of it too
+	FBallSpawnOccupancy Occupancy = BuildOccupancy(Ignore);
+	TBitArray<> Taken(false, SpawnPoints.Num());
+
+	for (int32 Player = 0; Player < NumPlayers; ++Player)
+	{
+		int32 Index = FindClearSpawnPoint(Occupancy, Taken);
+		if (Index == INDEX_NONE)
+		{
+			// More players than clear points: overlapping beats not spawning
+			UE_LOG(LogBallGuys, Warning, TEXT("Spawn registry: no clear spawn point left for player %d of %d"), Player + 1, NumPlayers);
+			Index = FMath::RandRange(0, SpawnPoints.Num() - 1);
+		}
+
+		Taken[Index] = true;
+		Occupancy.Add(SpawnPoints[Index]->GetActorLocation());
+		OutSpawnPoints.Add(SpawnPoints[Index]);
+	}
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "BallGuysSpawnSubsystem.generated.h"
+
+class APlayerStart;
+class ULevel;
+
+/**
+ * Spatial hash of the balls in play, for checking whether a spawn point is clear.
+ * Cells are as big as the clearance, so a check only ever looks at the 27 cells around the point.
+ */
+struct FBallSpawnOccupancy
+{
+	explicit FBallSpawnOccupancy(float InClearance);
+
+	void Add(const FVector& Location);
+
+	/** True if nothing added is within the clearance of Location. */
+	bool IsClear(const FVector& Location) const;
+
+private:
+	FIntVector GetCell(const FVector& Location) const;
+
+	float Clearance;
+	TMap<FIntVector, TArray<FVector, TInlineAllocator<2>>> Cells;
+};
+
+/**
+ * Registry of the world's player starts, for respawns.
+ * Built once when play begins and kept up to date as levels stream in and out, so respawning
+ * never searches the world for actors. Spawn points are picked at random among those that are
+ * clear of every ball in play; a whole match is placed in one pass that also keeps the players
+ * clear of each other.
+ */
+UCLASS()
+class BALLGUYS_API UBallGuysSpawnSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void OnWorldBeginPlay(UWorld& InWorld) override;
+	virtual void Deinitialize() override;
+
+	/**
+	 * A random spawn point clear of every ball in play except Ignore (the respawning player's own ball).
+	 * Falls back to any spawn point when none is clear; null only if there are none at all.
+	 */
+	APlayerStart* ChooseSpawnPoint(const AActor* Ignore = nullptr);
+
+	/**
+	 * One spawn point per player, clear of each other and of every ball in play except the Ignore ones
+	 * (the players' own balls, which are about to move). Points are reused only once every clear one is taken.
+	 */
+	void ChooseSpawnPoints(int32 NumPlayers, const TArray<const AActor*>& Ignore, TArray<APlayerStart*>& OutSpawnPoints);
+
+	int32 GetNumSpawnPoints() const { return SpawnPoints.Num(); }
+
+	/** How far (cm) a spawn point has to be from any ball's centre to count as clear. A bit over a ball's diameter. */
+	static constexpr float SpawnClearance = 150.f;
+
+protected:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+private:
+	UPROPERTY()
+	TArray<APlayerStart*> SpawnPoints;
+
+	bool bBuilt = false;
+
+	void Build();
+	void AddLevel(ULevel* Level);
+
+	void OnLevelAdded(ULevel* Level, UWorld* InWorld);
+	void OnLevelRemoved(ULevel* Level, UWorld* InWorld);
+
+	/** Occupancy of every ball in play but the Ignore ones. */
+	FBallSpawnOccupancy BuildOccupancy(TConstArrayView<const AActor*> Ignore) const;
+
+	/** Random clear spawn point that isn't in Taken, or INDEX_NONE. Visits every point at most once, from a random start. */
+	int32 FindClearSpawnPoint(const FBallSpawnOccupancy& Occupancy, const TBitArray<>& Taken) const;
+
+	FDelegateHandle LevelAddedHandle;
+	FDelegateHandle LevelRemovedHandle;
+};
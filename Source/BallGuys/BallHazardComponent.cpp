@@ -0,0 +1,143 @@
+#include "BallHazardComponent.h"
+#include "BallGuys.h"
+#include "BallGuysClockSubsystem.h"
+#include "BallGuysHazardSubsystem.h"
+#include "Components/PrimitiveComponent.h"
+#include "Curves/CurveFloat.h"
+#include "GameFramework/Actor.h"
+#include "Net/UnrealNetwork.h"
+#include "Net/Core/PushModel/PushModel.h"
+
+UBallHazardComponent::UBallHazardComponent()
+{
+	// Driven by UBallGuysHazardSubsystem
+	PrimaryComponentTick.bCanEverTick = false;
+	SetIsReplicatedByDefault(true);
+}
+
+void UBallHazardComponent::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
+{
+	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
+
+	// Only ever changes through SetSchedule
+	FDoRepLifetimeParams ScheduleParams;
+	ScheduleParams.bIsPushBased = true;
+	DOREPLIFETIME_WITH_PARAMS_FAST(UBallHazardComponent, Schedule, ScheduleParams);
+}
+
+void UBallHazardComponent::BeginPlay()
+{
+	Super::BeginPlay();
+
+	AActor* Owner = GetOwner();
+	Target = Owner ? Owner->GetRootComponent() : nullptr;
+	if (Owner && !TargetComponentName.IsNone())
+	{
+		for (UActorComponent* Component : Owner->GetComponents())
+		{
+			if (Component->GetFName() == TargetComponentName && Component->IsA<USceneComponent>())
+			{
+				Target = Cast<USceneComponent>(Component);
+				break;
+			}
+		}
+	}
+
+	if (!Target)
+	{
+		UE_LOG(LogBallGuys, Warning, TEXT("%s: no component to move"), *GetPathName());
+		return;
+	}
+
+	// Every machine computes the pose itself; replicating it as well would only fight the schedule
+	if (Target == Owner->GetRootComponent())
+	{
+		Owner->SetReplicateMovement(false);
+	}
+	Target->SetMobility(EComponentMobility::Movable);
+	BaseTransform = Target->GetRelativeTransform();
+	if (const UPrimitiveComponent* Primitive = Cast<UPrimitiveComponent>(Target))
+	{
+		PlacedCollision = Primitive->GetCollisionEnabled();
+	}
+
+	if (UBallGuysHazardSubsystem* Hazards = GetWorld()->GetSubsystem<UBallGuysHazardSubsystem>())
+	{
+		Hazards->RegisterHazard(this);
+	}
+	UpdateTarget(UBallGuysClockSubsystem::GetServerTime(GetWorld()));
+}
+
+void UBallHazardComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (UBallGuysHazardSubsystem* Hazards = GetWorld()->GetSubsystem<UBallGuysHazardSubsystem>())
+	{
+		Hazards->UnregisterHazard(this);
+	}
+
+	Super::EndPlay(EndPlayReason);
+}
+
+void UBallHazardComponent::SetSchedule(const FBallHazardSchedule& NewSchedule, bool bRestart)
+{
+	if (!GetOwner() || !GetOwner()->HasAuthority())
+	{
+		return;
+	}
+
+	const double StartServerTime = bRestart ? UBallGuysClockSubsystem::GetServerTime(GetWorld()) : Schedule.StartServerTime;
+	Schedule = NewSchedule;
+	Schedule.StartServerTime = StartServerTime;
+	MARK_PROPERTY_DIRTY_FROM_NAME(UBallHazardComponent, Schedule, this);
+}
+
+void UBallHazardComponent::Evaluate(double ServerTime, FTransform& OutRelativeTransform, bool& bOutPresent) const
+{
+	const double Period = FMath::Max(Schedule.Period, 0.01f);
+
+	// Wrapped in double before narrowing, so a long match doesn't lose precision in the cycle fraction
+	const double Cycles = (ServerTime - Schedule.StartServerTime) / Period + Schedule.Phase;
+	const float CycleFraction = static_cast<float>(Cycles - FMath::FloorToDouble(Cycles));
+
+	const float Alpha = Schedule.Curve ? Schedule.Curve->GetFloatValue(CycleFraction) : CycleFraction;
+
+	const FQuat Rotation = FQuat(Schedule.Rotation * Alpha);
+	OutRelativeTransform = BaseTransform;
+	OutRelativeTransform.SetRotation(BaseTransform.GetRotation() * Rotation);
+	OutRelativeTransform.SetTranslation(BaseTransform.GetTranslation() + Schedule.Translation * Alpha);
+
+	bOutPresent = CycleFraction < Schedule.ActiveFraction || Schedule.ActiveFraction >= 1.f;
+}
+
+void UBallHazardComponent::UpdateTarget(double ServerTime)
+{
+	if (!Target)
+	{
+		return;
+	}
+
+	FTransform RelativeTransform;
+	bool bNowPresent = true;
+	Evaluate(ServerTime, RelativeTransform, bNowPresent);
+
+	if (!Schedule.Rotation.IsZero() || !Schedule.Translation.IsZero())
+	{
+		Target->SetRelativeTransform(RelativeTransform, false, nullptr, ETeleportType::None);
+	}
+	SetPresent(bNowPresent);
+}
+
+void UBallHazardComponent::SetPresent(bool bInPresent)
+{
+	if (bPresent == bInPresent)
+	{
+		return;
+	}
+	bPresent = bInPresent;
+
+	Target->SetVisibility(bInPresent, true);
+	if (UPrimitiveComponent* Primitive = Cast<UPrimitiveComponent>(Target))
+	{
+		Primitive->SetCollisionEnabled(bInPresent ? PlacedCollision.GetValue() : ECollisionEnabled::NoCollision);
+	}
+}
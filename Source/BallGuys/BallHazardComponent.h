@@ -0,0 +1,106 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/ActorComponent.h"
+#include "BallHazardComponent.generated.h"
+
+class UCurveFloat;
+class USceneComponent;
+
+/**
+ * When and how a hazard moves. Every cycle of Period seconds, the curve maps how far through the
+ * cycle we are (0-1) to how far through its motion the hazard is (0-1): at 1 it's turned by Rotation
+ * and moved by Translation from where it was placed. A spinner is a full turn with no curve; a pusher
+ * is a Translation with a curve that goes out and back.
+ */
+USTRUCT(BlueprintType)
+struct FBallHazardSchedule
+{
+	GENERATED_BODY()
+
+	/** Seconds per cycle. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Hazard", meta = (ClampMin = "0.01"))
+	float Period = 4.f;
+
+	/** Fraction of a cycle (0-1) this hazard runs ahead of others with the same schedule, to stagger a row of them. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Hazard", meta = (ClampMin = "0", ClampMax = "1"))
+	float Phase = 0.f;
+
+	/** Cycle fraction -> motion fraction. Straight through (a steady spin or slide) when unset. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Hazard")
+	UCurveFloat* Curve = nullptr;
+
+	/** Rotation at motion fraction 1, relative to the placed rotation. 360 degrees of yaw is one turn per cycle. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Hazard")
+	FRotator Rotation = FRotator::ZeroRotator;
+
+	/** Offset at motion fraction 1, in the placed component's parent space. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Hazard")
+	FVector Translation = FVector::ZeroVector;
+
+	/** Fraction of each cycle, from its start, the hazard is there: visible and solid. Below 1 it vanishes for the rest. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Hazard", meta = (ClampMin = "0", ClampMax = "1"))
+	float ActiveFraction = 1.f;
+
+	/** Server time cycle 0 started at. 0 keeps every hazard in step with the match clock. */
+	UPROPERTY(BlueprintReadOnly, Category = "Hazard")
+	double StartServerTime = 0.0;
+};
+
+/**
+ * Moves a kinematic part of its actor (a spinner's arm, a vanishing wall) as a pure function of
+ * server time and its schedule. The server and every client compute the same pose from the shared
+ * clock (UBallGuysClockSubsystem), so nothing is replicated per frame: the owner doesn't replicate
+ * movement, and the schedule replicates only when the server changes it.
+ *
+ * Doesn't tick: UBallGuysHazardSubsystem updates every hazard in one pre-physics pass. The target is
+ * moved rather than teleported, so a kinematic body carries its velocity into the contacts with balls.
+ */
+UCLASS(ClassGroup = (BallGuys), meta = (BlueprintSpawnableComponent))
+class BALLGUYS_API UBallHazardComponent : public UActorComponent
+{
+	GENERATED_BODY()
+
+public:
+	UBallHazardComponent();
+
+	virtual void GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const override;
+
+	/** Server: replaces the schedule; with bRestart, cycle 0 starts now instead of at the old start time. */
+	UFUNCTION(BlueprintCallable, BlueprintAuthorityOnly, Category = "Hazard")
+	void SetSchedule(const FBallHazardSchedule& NewSchedule, bool bRestart = false);
+
+	const FBallHazardSchedule& GetSchedule() const { return Schedule; }
+
+	/** The target's relative transform at ServerTime, and whether it's there. Pure: the same on every machine. */
+	void Evaluate(double ServerTime, FTransform& OutRelativeTransform, bool& bOutPresent) const;
+
+	/** Moves the target to its pose at ServerTime. */
+	void UpdateTarget(double ServerTime);
+
+	/** Name of the component to move. The owner's root when none. */
+	UPROPERTY(EditAnywhere, Category = "Hazard")
+	FName TargetComponentName;
+
+protected:
+	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+	/** Nothing to do when it arrives: the next update evaluates the new schedule at the current time. */
+	UPROPERTY(EditAnywhere, Replicated, Category = "Hazard")
+	FBallHazardSchedule Schedule;
+
+private:
+	UPROPERTY()
+	USceneComponent* Target = nullptr;
+
+	/** The target's relative transform as placed, which the schedule is applied on top of. */
+	FTransform BaseTransform;
+
+	/** The target's collision as placed, restored whenever it reappears. */
+	TEnumAsByte<ECollisionEnabled::Type> PlacedCollision = ECollisionEnabled::QueryAndPhysics;
+
+	bool bPresent = true;
+
+	void SetPresent(bool bInPresent);
+};
@@ -0,0 +1,94 @@
+#include "BallInputQueue.h"
+
+void FBallInputQueue::Push(const FBallInputPacket& Packet, float StepInterval, double Now)
+{
+	int32 NumNewFrames = 0;
+
+	for (const FBallInputFrame& Frame : Packet.Frames)
+	{
+		// Consumed already, or skipped past: too late to matter
+		if (bHasConsumed && !FBallInputFrame::IsNewer(Frame.Sequence, LastConsumedSequence))
+		{
+			++NumDropped;
+			continue;
+		}
+
+		// Packets can arrive out of order, so insert rather than append
+		int32 InsertAt = Frames.Num();
+		while (InsertAt > 0 && FBallInputFrame::IsNewer(Frames[InsertAt - 1].Sequence, Frame.Sequence))
+		{
+			--InsertAt;
+		}
+		if (InsertAt > 0 && Frames[InsertAt - 1].Sequence == Frame.Sequence)
+		{
+			++NumDropped;
+			continue;
+		}
+
+		Frames.Insert(Frame, InsertAt);
+		++NumNewFrames;
+	}
+
+	if (NumNewFrames > 0)
+	{
+		UpdateTargetDepth(Frames.Last().Sequence, NumNewFrames, StepInterval, Now);
+	}
+}
+
+bool FBallInputQueue::Pop(FBallInputFrame& OutFrame)
+{
+	if (!bDraining)
+	{
+		if (Frames.Num() < TargetDepth)
+		{
+			return false;
+		}
+		bDraining = true;
+	}
+
+	if (Frames.Num() == 0)
+	{
+		bDraining = false;
+		++NumUnderruns;
+		return false;
+	}
+
+	// Too far behind the client: catch up, but a press in a skipped frame still happens
+	while (Frames.Num() > TargetDepth + OverflowSlack)
+	{
+		Frames[1].Flags |= Frames[0].Flags;
+		Frames.RemoveAt(0, 1, EAllowShrinking::No);
+		++NumSkipped;
+	}
+
+	OutFrame = Frames[0];
+	Frames.RemoveAt(0, 1, EAllowShrinking::No);
+
+	LastConsumedSequence = OutFrame.Sequence;
+	bHasConsumed = true;
+	return true;
+}
+
+void FBallInputQueue::UpdateTargetDepth(uint16 NewestSequence, int32 NumNewFrames, float StepInterval, double Now)
+{
+	// Only packets that move the stream forward say anything about its timing
+	if (LastArrivalTime >= 0.0 && !FBallInputFrame::IsNewer(NewestSequence, LastArrivalSequence))
+	{
+		return;
+	}
+
+	if (LastArrivalTime >= 0.0)
+	{
+		const int32 SequenceDelta = static_cast<int16>(NewestSequence - LastArrivalSequence);
+		const double Deviation = (Now - LastArrivalTime) - SequenceDelta * StepInterval;
+		Jitter += (FMath::Abs(Deviation) - Jitter) / 16.0;
+	}
+	LastArrivalSequence = NewestSequence;
+	LastArrivalTime = Now;
+
+	FramesPerPacket += (NumNewFrames - FramesPerPacket) / 8.f;
+
+	// One packet's worth of frames has to last until the next one, plus room for it to be late
+	const float JitterFrames = StepInterval > 0.f ? static_cast<float>(2.0 * Jitter / StepInterval) : 0.f;
+	TargetDepth = FMath::Clamp(FMath::CeilToInt(FramesPerPacket + JitterFrames), MinDepth, MaxDepth);
+}
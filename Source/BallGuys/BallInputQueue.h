@@ -0,0 +1,61 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "BallInputTypes.h"
+
+/**
+ * Server-side jitter buffer for one remote player's input stream.
+ * Packets are pushed as they arrive; frames are popped one per fixed input step, so how often
+ * and how bunched up the RPCs land doesn't change how much input a ball gets per second.
+ *
+ * - Frames already consumed or already queued (resends, late arrivals) are dropped on push
+ * - Depth adapts to the measured packet jitter, between MinDepth and MaxDepth frames
+ * - Running dry refills to the target depth before consuming again; the ball holds its last axes meanwhile
+ * - Running too far ahead skips the oldest frames, keeping their jump/boost presses
+ */
+struct BALLGUYS_API FBallInputQueue
+{
+	static constexpr int32 MinDepth = 1;
+	static constexpr int32 MaxDepth = 12;
+
+	/** Frames beyond the target depth tolerated before old ones are skipped. */
+	static constexpr int32 OverflowSlack = 3;
+
+	/** Adds the new frames of Packet. StepInterval is the time one frame covers; Now is the arrival time (real seconds). */
+	void Push(const FBallInputPacket& Packet, float StepInterval, double Now);
+
+	/** Next frame for this input step. False while buffering, the ball keeps its current input then. */
+	bool Pop(FBallInputFrame& OutFrame);
+
+	int32 Num() const { return Frames.Num(); }
+	int32 GetTargetDepth() const { return TargetDepth; }
+
+	// Counters since the last call to ResetStats, for CSV stats
+	int32 NumDropped = 0;
+	int32 NumSkipped = 0;
+	int32 NumUnderruns = 0;
+
+	void ResetStats() { NumDropped = NumSkipped = NumUnderruns = 0; }
+
+private:
+	/** Queued frames, oldest first, strictly increasing sequences. */
+	TArray<FBallInputFrame> Frames;
+
+	uint16 LastConsumedSequence = 0;
+	bool bHasConsumed = false;
+
+	/** False until the buffer first reaches TargetDepth, and again after running dry. */
+	bool bDraining = false;
+
+	int32 TargetDepth = 2;
+
+	// Jitter estimate (RFC 3550 style): how far packet spacing strays from the spacing of their frames
+	uint16 LastArrivalSequence = 0;
+	double LastArrivalTime = -1.0;
+	double Jitter = 0.0;
+
+	/** Average new frames per packet, i.e. the burst every packet delivers at once. */
+	float FramesPerPacket = 1.f;
+
+	void UpdateTargetDepth(uint16 NewestSequence, int32 NumNewFrames, float StepInterval, double Now);
+};
@@ -0,0 +1,73 @@
+#include "BallInputTypes.h"
+#include "BallGuysNetProfiler.h"
+
+void FBallInputFrame::SetAxes(float ForwardValue, float RightValue)
+{
+	Forward = static_cast<int8>(FMath::RoundToInt(FMath::Clamp(ForwardValue, -1.f, 1.f) * 127.f));
+	Right = static_cast<int8>(FMath::RoundToInt(FMath::Clamp(RightValue, -1.f, 1.f) * 127.f));
+}
+
+void FBallInputFrame::SetYaw(float YawDegrees)
+{
+	Yaw = FRotator::CompressAxisToShort(YawDegrees) >> (16 - YawBits);
+}
+
+float FBallInputFrame::GetYaw() const
+{
+	return FRotator::DecompressAxisFromShort(static_cast<uint16>(Yaw << (16 - YawBits)));
+}
+
+bool FBallInputPacket::NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess)
+{
+	FBallGuysNetProfiler::SerializeStruct(Ar, Map, TEXT("BallPawn"), TEXT("FBallInputPacket"), [this](FArchive& StructAr)
+	{
+		SerializePayload(StructAr);
+	});
+
+	bOutSuccess = !Ar.IsError();
+	return true;
+}
+
+void FBallInputPacket::SerializePayload(FArchive& Ar)
+{
+	// Only the newest sequence goes on the wire, the rest are implied by the count
+	uint16 NewestSequence = Frames.Num() > 0 ? Frames.Last().Sequence : 0;
+	uint32 NumFrames = FMath::Min(Frames.Num(), MaxFrames);
+
+	Ar << NewestSequence;
+	Ar.SerializeInt(NumFrames, MaxFrames + 1);
+
+	if (Ar.IsLoading())
+	{
+		Frames.SetNum(NumFrames);
+	}
+
+	const int32 FirstFrame = Frames.Num() - static_cast<int32>(NumFrames);
+	for (int32 Index = FirstFrame; Index < Frames.Num(); ++Index)
+	{
+		FBallInputFrame& Frame = Frames[Index];
+
+		// Most frames while coasting have no movement, so the axes are behind a bit
+		uint8 bHasMovement = Frame.HasMovement() ? 1 : 0;
+		Ar.SerializeBits(&bHasMovement, 1);
+		if (bHasMovement)
+		{
+			Ar.SerializeBits(&Frame.Forward, 8);
+			Ar.SerializeBits(&Frame.Right, 8);
+		}
+		else if (Ar.IsLoading())
+		{
+			Frame.Forward = 0;
+			Frame.Right = 0;
+		}
+
+		uint32 YawAndFlags = (static_cast<uint32>(Frame.Yaw) << EBallInputFlags::NumBits) | Frame.Flags;
+		Ar.SerializeBits(&YawAndFlags, FBallInputFrame::YawBits + EBallInputFlags::NumBits);
+		if (Ar.IsLoading())
+		{
+			Frame.Yaw = static_cast<uint16>((YawAndFlags >> EBallInputFlags::NumBits) & ((1u << FBallInputFrame::YawBits) - 1));
+			Frame.Flags = static_cast<uint8>(YawAndFlags & ((1u << EBallInputFlags::NumBits) - 1));
+			Frame.Sequence = static_cast<uint16>(NewestSequence - (Frames.Num() - 1 - Index));
+		}
+	}
+}
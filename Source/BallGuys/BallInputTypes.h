@@ -0,0 +1,81 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "BallInputTypes.generated.h"
+
+/** Edge-triggered actions that ride along with the movement axes. */
+namespace EBallInputFlags
+{
+	enum Type : uint8
+	{
+		None  = 0,
+		Jump  = 1 << 0,
+		Boost = 1 << 1,
+	};
+
+	constexpr int32 NumBits = 2;
+}
+
+/**
+ * One sampled frame of owning-client input.
+ * Axes are quantized to a signed byte, yaw to YawBits; only yaw matters for movement.
+ */
+USTRUCT()
+struct BALLGUYS_API FBallInputFrame
+{
+	GENERATED_BODY()
+
+	static constexpr int32 YawBits = 12;
+
+	/** Sequence number, assigned by the owning client. Wraps around. */
+	uint16 Sequence = 0;
+
+	int8 Forward = 0;
+	int8 Right = 0;
+	uint16 Yaw = 0;
+
+	/** EBallInputFlags set on the frame the action was pressed. */
+	uint8 Flags = 0;
+
+	void SetAxes(float ForwardValue, float RightValue);
+	void SetYaw(float YawDegrees);
+
+	float GetForward() const { return Forward / 127.f; }
+	float GetRight() const { return Right / 127.f; }
+	float GetYaw() const;
+
+	bool HasMovement() const { return Forward != 0 || Right != 0; }
+	bool HasFlag(EBallInputFlags::Type Flag) const { return (Flags & Flag) != 0; }
+
+	/** Sequence comparison that survives wrap-around. */
+	static bool IsNewer(uint16 A, uint16 B) { return static_cast<int16>(A - B) > 0; }
+};
+
+/**
+ * What the owning client sends to the server every send interval.
+ * Frames are consecutive and oldest first; the newest ones are new, the rest are
+ * resent so that a lost packet doesn't cost any movement.
+ */
+USTRUCT()
+struct BALLGUYS_API FBallInputPacket
+{
+	GENERATED_BODY()
+
+	static constexpr int32 MaxFrames = 16;
+
+	TArray<FBallInputFrame> Frames;
+
+	bool NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess);
+
+	/** The wire format; NetSerialize runs it through the bandwidth profiler. */
+	void SerializePayload(FArchive& Ar);
+};
+
+template<>
+struct TStructOpsTypeTraits<FBallInputPacket> : public TStructOpsTypeTraitsBase2<FBallInputPacket>
+{
+	enum
+	{
+		WithNetSerializer = true
+	};
+};
@@ -0,0 +1,157 @@
+#include "BallInterpolationComponent.h"
+#include "BallGuys.h"
+#include "BallRepState.h"
+#include "Components/PrimitiveComponent.h"
+#include "GameFramework/Actor.h"
+
+namespace BallInterpolation
+{
+	/** Rotation after spinning at AngularVelocity (world space, radians per second) for Seconds, which can be negative. */
+	FQuat Integrate(const FQuat& Rotation, const FVector& AngularVelocity, double Seconds)
+	{
+		const double Speed = AngularVelocity.Size();
+		if (Speed * FMath::Abs(Seconds) < UE_KINDA_SMALL_NUMBER)
+		{
+			return Rotation;
+		}
+		return FQuat(AngularVelocity / Speed, Speed * Seconds) * Rotation;
+	}
+}
+
+UBallInterpolationComponent::UBallInterpolationComponent()
+{
+	// Driven by UBallSimulationSubsystem
+	PrimaryComponentTick.bCanEverTick = false;
+}
+
+void UBallInterpolationComponent::AddSnapshot(const FBallRepState& State, double ServerTime, float Radius)
+{
+	FBallSnapshot Snapshot;
+	Snapshot.Time            = ServerTime;
+	Snapshot.Location        = State.Location;
+	Snapshot.Rotation        = State.Rotation;
+	Snapshot.LinearVelocity  = State.LinearVelocity;
+	Snapshot.AngularVelocity = State.bAngularFromRolling
+		? FBallRepState::DeriveRollingAngularVelocity(State.LinearVelocity, Radius)
+		: State.AngularVelocity;
+
+	if (Snapshots.Num() > 0)
+	{
+		const FBallSnapshot& Newest = Snapshots.Last();
+
+		// Property updates don't arrive out of order, but a stale one after a reset can
+		if (ServerTime <= Newest.Time)
+		{
+			return;
+		}
+
+		if (FVector::DistSquared(Newest.Location, Snapshot.Location) > FMath::Square(TeleportDistance))
+		{
+			Snapshots.Reset();
+			bSnapNextUpdate = true;
+		}
+		else if (ServerTime - Newest.Time > MaxSnapshotGap)
+		{
+			// Nothing was sent because nothing changed: it was still where Newest has it until one send interval ago
+			const AActor* Owner = GetOwner();
+			const double SendInterval = Owner ? 1.0 / FMath::Max(Owner->GetNetUpdateFrequency(), 1.f) : MaxSnapshotGap;
+
+			FBallSnapshot Held = Newest;
+			Held.Time = FMath::Max(ServerTime - SendInterval, Newest.Time);
+			Held.LinearVelocity = FVector::ZeroVector;
+			Held.AngularVelocity = FVector::ZeroVector;
+			Snapshots.Add(Held);
+		}
+	}
+
+	Snapshots.Add(Snapshot);
+	if (Snapshots.Num() > MaxSnapshots)
+	{
+		Snapshots.RemoveAt(0, Snapshots.Num() - MaxSnapshots, EAllowShrinking::No);
+	}
+}
+
+void UBallInterpolationComponent::UpdateBody(UPrimitiveComponent& Body, double ServerNow)
+{
+	if (Snapshots.Num() == 0)
+	{
+		return;
+	}
+
+	const double RenderTime = ServerNow - InterpolationDelay;
+
+	FBallSnapshot Pose;
+	if (RenderTime <= Snapshots[0].Time)
+	{
+		Pose = Snapshots[0];
+	}
+	else if (RenderTime >= Snapshots.Last().Time)
+	{
+		// Next state is late: carry on for a bit, then hold still rather than fly off
+		const double Ahead = FMath::Min(RenderTime - Snapshots.Last().Time, static_cast<double>(MaxExtrapolation));
+		Pose = Extrapolate(Snapshots.Last(), Ahead);
+		CSV_CUSTOM_STAT(BallGuys, InterpolationExtrapolated, 1, ECsvCustomStatOp::Accumulate);
+
+		// Only the newest is needed from here on
+		Snapshots.RemoveAt(0, Snapshots.Num() - 1, EAllowShrinking::No);
+	}
+	else
+	{
+		int32 Older = 0;
+		while (Snapshots[Older + 1].Time <= RenderTime)
+		{
+			++Older;
+		}
+		Pose = Hermite(Snapshots[Older], Snapshots[Older + 1], RenderTime);
+
+		// Everything before the pair we're in is behind us
+		Snapshots.RemoveAt(0, Older, EAllowShrinking::No);
+	}
+
+	Body.SetWorldLocationAndRotation(Pose.Location, Pose.Rotation, false, nullptr,
+		bSnapNextUpdate ? ETeleportType::TeleportPhysics : ETeleportType::None);
+	bSnapNextUpdate = false;
+}
+
+void UBallInterpolationComponent::Reset()
+{
+	Snapshots.Reset();
+	bSnapNextUpdate = true;
+}
+
+FBallSnapshot UBallInterpolationComponent::Hermite(const FBallSnapshot& A, const FBallSnapshot& B, double Time)
+{
+	const double Span = B.Time - A.Time;
+	const double T  = FMath::Clamp((Time - A.Time) / Span, 0.0, 1.0);
+	const double T2 = T * T;
+	const double T3 = T2 * T;
+
+	// Cubic Hermite basis; tangents are the velocities scaled to the span
+	const double H00 = 2.0 * T3 - 3.0 * T2 + 1.0;
+	const double H10 = T3 - 2.0 * T2 + T;
+	const double H01 = -2.0 * T3 + 3.0 * T2;
+	const double H11 = T3 - T2;
+
+	FBallSnapshot Result;
+	Result.Time            = Time;
+	Result.Location        = H00 * A.Location + H10 * Span * A.LinearVelocity + H01 * B.Location + H11 * Span * B.LinearVelocity;
+	Result.LinearVelocity  = FMath::Lerp(A.LinearVelocity, B.LinearVelocity, T);
+	Result.AngularVelocity = FMath::Lerp(A.AngularVelocity, B.AngularVelocity, T);
+
+	// A fast ball turns more than half a revolution between states, too much for a plain slerp:
+	// spin each end towards Time with its own angular velocity, then blend the two
+	const FQuat FromA = BallInterpolation::Integrate(A.Rotation, A.AngularVelocity, Time - A.Time);
+	const FQuat FromB = BallInterpolation::Integrate(B.Rotation, B.AngularVelocity, Time - B.Time);
+	Result.Rotation = FQuat::Slerp(FromA, FromB, T).GetNormalized();
+
+	return Result;
+}
+
+FBallSnapshot UBallInterpolationComponent::Extrapolate(const FBallSnapshot& From, double Seconds)
+{
+	FBallSnapshot Result = From;
+	Result.Time     = From.Time + Seconds;
+	Result.Location = From.Location + From.LinearVelocity * Seconds;
+	Result.Rotation = BallInterpolation::Integrate(From.Rotation, From.AngularVelocity, Seconds);
+	return Result;
+}
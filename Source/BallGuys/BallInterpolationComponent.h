@@ -0,0 +1,73 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/ActorComponent.h"
+#include "BallInterpolationComponent.generated.h"
+
+struct FBallRepState;
+
+/** One timestamped server state of a remote ball. */
+struct FBallSnapshot
+{
+	double Time = 0.0; // server time
+	FVector Location = FVector::ZeroVector;
+	FQuat Rotation = FQuat::Identity;
+	FVector LinearVelocity = FVector::ZeroVector;
+	FVector AngularVelocity = FVector::ZeroVector; // radians
+};
+
+/**
+ * Client-side snapshot interpolation for balls we don't own.
+ * Buffers the timestamped FBallRepStates the server sends and shows the ball InterpolationDelay
+ * behind the server clock, Hermite-interpolated between the two states around that time using their
+ * velocities. When the next state is late it extrapolates from the newest, for up to MaxExtrapolation.
+ *
+ * Doesn't tick: UBallSimulationSubsystem calls UpdateBody for every interpolated ball in its pass.
+ * The body is kinematic meanwhile (see ABallPawn::UpdateSimulationMode), so our own predicted ball
+ * still collides with it.
+ */
+UCLASS(ClassGroup = (BallGuys))
+class BALLGUYS_API UBallInterpolationComponent : public UActorComponent
+{
+	GENERATED_BODY()
+
+public:
+	UBallInterpolationComponent();
+
+	/** Adds a state received from the server. ServerTime is its unwrapped timestamp. */
+	void AddSnapshot(const FBallRepState& State, double ServerTime, float Radius);
+
+	/** Moves Body to where the ball was InterpolationDelay before ServerNow. */
+	void UpdateBody(UPrimitiveComponent& Body, double ServerNow);
+
+	/** Drops everything buffered, e.g. when we start or stop interpolating this ball. */
+	void Reset();
+
+	/** How far behind the server clock remote balls are shown. A few send intervals, so one late or lost state doesn't starve the buffer. */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Ball|Network", meta = (ClampMin = "0"))
+	float InterpolationDelay = 0.1f;
+
+	/** How far past the newest state (seconds) we keep extrapolating before holding still. */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Ball|Network", meta = (ClampMin = "0"))
+	float MaxExtrapolation = 0.15f;
+
+	/** States further apart than this (cm) are a teleport, e.g. a respawn: snap instead of interpolating across. */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Ball|Network")
+	float TeleportDistance = 500.f;
+
+	/** The server doesn't resend a ball that hasn't changed; a gap longer than this means it sat still until the new state. */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Ball|Network")
+	float MaxSnapshotGap = 0.25f;
+
+	static constexpr int32 MaxSnapshots = 16;
+
+private:
+	/** Oldest first, increasing Time. */
+	TArray<FBallSnapshot> Snapshots;
+
+	/** Set when the next UpdateBody has to teleport rather than sweep the kinematic body there. */
+	bool bSnapNextUpdate = true;
+
+	static FBallSnapshot Hermite(const FBallSnapshot& A, const FBallSnapshot& B, double Time);
+	static FBallSnapshot Extrapolate(const FBallSnapshot& From, double Seconds);
+};
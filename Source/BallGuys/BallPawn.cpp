@@ -3,6 +3,10 @@
 // BallPawn.cpp
 
 #include "BallPawn.h"
+#include "BallGuys.h"
+#include "BallSimulationSubsystem.h"
+#include "BallInterpolationComponent.h"
+#include "BallGuysClockSubsystem.h"
 
 #include "Camera/CameraComponent.h"
 #include "Components/StaticMeshComponent.h"
@@ -17,10 +21,13 @@
 #include "InputMappingContext.h"
 #include "InputAction.h"
 #include "Net/UnrealNetwork.h"
+#include "Net/Core/PushModel/PushModel.h"
+#include "PhysicsProxy/SingleParticlePhysicsProxy.h"
 
 ABallPawn::ABallPawn()
 {
-    PrimaryActorTick.bCanEverTick = true;
+    // Stepped by UBallSimulationSubsystem together with every other ball
+    PrimaryActorTick.bCanEverTick = false;
 
     // ----------------- Components -----------------
 
@@ -33,11 +40,13 @@ ABallPawn::ABallPawn()
     MeshComp->SetLinearDamping(0.6f); //slows how far it coasts
     MeshComp->SetAngularDamping(0.8f); //slow spin
     MeshComp->SetCollisionProfileName(UCollisionProfile::PhysicsActor_ProfileName);
+    // FBallRepState can't represent anything faster
+    MeshComp->BodyInstance.SetMaxAngularVelocityInRadians(FBallRepState::MaxAngularSpeed, false);
 
-    // Make sure hit events are generated (for NotifyHit)
-    MeshComp->SetNotifyRigidBodyCollision(true);
-    MeshComp->BodyInstance.bNotifyRigidBodyCollision = true;
-    MeshComp->SetGenerateOverlapEvents(true);
+    // No hit events: knockback and ground contacts come straight out of the physics step (FBallContactModifier)
+    // No overlap events either: kill volumes are checked by position (UBallGuysEliminationSubsystem)
+    MeshComp->SetNotifyRigidBodyCollision(false);
+    MeshComp->SetGenerateOverlapEvents(false);
 
     // Create a spring arm
     SpringArm = CreateDefaultSubobject<USpringArmComponent>(TEXT("SpringArm"));
@@ -52,98 +61,298 @@ ABallPawn::ABallPawn()
     Camera->SetupAttachment(SpringArm, USpringArmComponent::SocketName);
     Camera->bUsePawnControlRotation = false; // We already rotate the spring arm
 
+    Interpolation = CreateDefaultSubobject<UBallInterpolationComponent>(TEXT("Interpolation"));
+
     // ----------------- Replication -----------------
 
     // This pawn should exist on server and all clients
     SetReplicates(true);
-    // Let the engine replicate physics movement for us
-    SetReplicateMovement(true);
-    // Optional: tweak net update rate
-    SetNetUpdateFrequency(100.f);
-    SetMinNetUpdateFrequency(30.f);
+    // Physics state goes through ReplicatedBallState / ServerAck instead of the generic FRepMovement
+    SetReplicateMovement(false);
+    // Remote balls are interpolated between states (UBallInterpolationComponent), so 30 Hz looks smooth
+    SetNetUpdateFrequency(30.f);
+    SetMinNetUpdateFrequency(10.f);
 
     // ----------------- Movement tuning defaults -----------------
 
     TorqueStrength        = 40.f;  // "How hard we roll" 
     JumpImpulse           = 1000.f;    // "How hard we jump"
     GroundCheckDistance   = -45.f;        // Distance below the ball to look for ground DO NOT GO PAST -49.f
-    KnockImpulseStrength  = 200000.f;    // Impulse to shove other balls
+    KnockRestitution      = 1.2f;        // Bounce between balls, a bit livelier than a real collision
+    KnockSpeedThreshold   = 1500.f;      // About the speed the old flat knock impulse gave a ball; slower bumps don't gain energy
 
     CachedForwardInput = 0.f;
     CachedRightInput   = 0.f;
-
-    // Saving base values so boost can scale them
-    BaseTorqueStrength = TorqueStrength;
-    BaseKnockImpulseStrength = KnockImpulseStrength;
 }
 
 void ABallPawn::BeginPlay()
 {
     Super::BeginPlay();
-    
-    // Caching base values once so boosts have something to multiply
-    BaseTorqueStrength = TorqueStrength;
-    BaseKnockImpulseStrength = KnockImpulseStrength;
-    
-   
+
+    PredictionBuffer.SetNum(PredictionBufferSize);
+
+    if (UBallSimulationSubsystem* Simulation = GetSimulation())
+    {
+        FBallTuning Tuning;
+        Tuning.TorqueStrength  = TorqueStrength;
+        Tuning.BoostMultiplier = BoostMultiplier;
+        Tuning.BoostDuration   = BoostDuration;
+        Tuning.GroundCheckDistance = GroundCheckDistance;
+        Tuning.KnockRestitution    = KnockRestitution;
+        Tuning.KnockSpeedThreshold = KnockSpeedThreshold;
+        Tuning.InputStepInterval   = 1.f / FMath::Max(InputSampleRate, 1.f);
+        Tuning.RemoteViewDelay     = Interpolation ? Interpolation->InterpolationDelay : 0.f;
+
+        SimulationIndex = Simulation->RegisterBall(this, MeshComp, Tuning);
+        Simulation->SetLocallyControlled(SimulationIndex, IsLocallyControlled());
+        SyncBoostToSimulation();
+    }
+
+    if (MeshComp)
+    {
+        MeshComp->OnComponentPhysicsStateChanged.AddDynamic(this, &ABallPawn::OnMeshPhysicsStateChanged);
+    }
+    ApplyMaxLinearSpeed();
+
+    UpdateSimulationMode();
 }
 
-void ABallPawn::Tick(float DeltaSeconds)
+void ABallPawn::ApplyMaxLinearSpeed()
 {
-    Super::Tick(DeltaSeconds);
- 
-    // Tick, tick....BOOST!
-    // Only the server updates the boost timers / state
-    if (HasAuthority())
+    const FBodyInstance* BodyInstance = MeshComp ? MeshComp->GetBodyInstance() : nullptr;
+    if (const FPhysicsActorHandle Handle = BodyInstance ? BodyInstance->GetPhysicsActor() : nullptr)
     {
-        // Handle active boost
-        if (bIsBoosting)
-        {
-            BoostTimeRemaining -= DeltaSeconds;
-            if (BoostTimeRemaining <= 0.f)
-            {
-                bIsBoosting        = false;
-                BoostTimeRemaining = 0.f;
+        // FBallRepState can't represent anything faster
+        Handle->GetGameThreadAPI().SetMaxLinearSpeedSq(FMath::Square(FBallRepState::MaxLinearSpeed));
+    }
+}
 
-                // Restore normal strengths
-                TorqueStrength       = BaseTorqueStrength;
-                KnockImpulseStrength = BaseKnockImpulseStrength;
-            }
-        }
+void ABallPawn::OnMeshPhysicsStateChanged(UPrimitiveComponent* ChangedComponent, EComponentPhysicsStateChange StateChange)
+{
+    if (StateChange == EComponentPhysicsStateChange::Created)
+    {
+        ApplyMaxLinearSpeed();
+    }
+}
 
-        // Handle cooldown ticking down
-        if (CooldownTimeRemaining > 0.f)
-        {
-            CooldownTimeRemaining -= DeltaSeconds;
-            if (CooldownTimeRemaining < 0.f)
-            {
-                CooldownTimeRemaining = 0.f;
-            }
-        }
+void ABallPawn::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+    if (UBallSimulationSubsystem* Simulation = GetSimulation())
+    {
+        Simulation->UnregisterBall(SimulationIndex);
+    }
+    SimulationIndex = INDEX_NONE;
+
+    Super::EndPlay(EndPlayReason);
+}
+
+UBallSimulationSubsystem* ABallPawn::GetSimulation() const
+{
+    const UWorld* World = GetWorld();
+    return World ? World->GetSubsystem<UBallSimulationSubsystem>() : nullptr;
+}
+
+void ABallPawn::NotifyControllerChanged()
+{
+    Super::NotifyControllerChanged();
+
+    if (UBallSimulationSubsystem* Simulation = GetSimulation())
+    {
+        Simulation->SetLocallyControlled(SimulationIndex, IsLocallyControlled());
+        // A new controller starts from no input, and its own sequence numbers
+        Simulation->ResetInput(SimulationIndex);
     }
+
+    UpdateSimulationMode();
 }
+
+void ABallPawn::SetPooled(bool bInPooled)
+{
+    bPooled = bInPooled;
+
+    SetActorHiddenInGame(bInPooled);
+    SetActorEnableCollision(!bInPooled);
+    if (MeshComp)
+    {
+        MeshComp->SetSimulatePhysics(!bInPooled);
+    }
+    if (!bInPooled)
+    {
+        ApplyMaxLinearSpeed();
+    }
+}
+
+void ABallPawn::ResetForRespawn(const FTransform& SpawnTransform)
+{
+    SetPooled(false);
+
+    SetActorLocationAndRotation(SpawnTransform.GetLocation(), SpawnTransform.GetRotation(), false, nullptr, ETeleportType::ResetPhysics);
+    if (MeshComp)
+    {
+        MeshComp->SetPhysicsLinearVelocity(FVector::ZeroVector);
+        MeshComp->SetPhysicsAngularVelocityInRadians(FVector::ZeroVector);
+    }
+
+    // A fresh life starts off cooldown
+    if (BoostStartServerTime >= 0.0)
+    {
+        BoostStartServerTime = -1.0;
+        MARK_PROPERTY_DIRTY_FROM_NAME(ABallPawn, BoostStartServerTime, this);
+    }
+    PredictedBoostStartTime = -1.0;
+    SyncBoostToSimulation();
+
+    if (UBallSimulationSubsystem* Simulation = GetSimulation())
+    {
+        Simulation->ClearGrounded(SimulationIndex);
+        Simulation->ResetHistory(SimulationIndex);
+        Simulation->ResetElimination(SimulationIndex);
+    }
+}
+
+void ABallPawn::UpdateSimulationMode()
+{
+    if (GetNetMode() != NM_Client || !MeshComp || !Interpolation)
+    {
+        return;
+    }
+
+    const bool bInterpolate = !IsLocallyControlled();
+    if (bInterpolate == !MeshComp->IsSimulatingPhysics())
+    {
+        return;
+    }
+
+    MeshComp->SetSimulatePhysics(!bInterpolate);
+    if (!bInterpolate)
+    {
+        ApplyMaxLinearSpeed();
+
+        // States buffered before we took over are of no use to the prediction
+        Interpolation->Reset();
+    }
+
+    if (UBallSimulationSubsystem* Simulation = GetSimulation())
+    {
+        Simulation->SetInterpolation(SimulationIndex, bInterpolate ? Interpolation : nullptr);
+    }
+}
+
+void ABallPawn::SyncBoostToSimulation()
+{
+    if (UBallSimulationSubsystem* Simulation = GetSimulation())
+    {
+        Simulation->SetBoostStartTime(SimulationIndex, GetEffectiveBoostStartTime());
+    }
+}
+
+void ABallPawn::TickLocalControl(float DeltaSeconds)
+{
+    BALLGUYS_SCOPE(Input);
+
+    TickPredictionCorrection(DeltaSeconds);
+    TickInputStream(DeltaSeconds);
+
+    // Held input is applied every frame by the simulation, so torque doesn't depend on how often input events fire
+    float Yaw = 0.f;
+    if (AController* PC = GetController())
+    {
+        Yaw = PC->GetControlRotation().Yaw;
+    }
+
+    if (UBallSimulationSubsystem* Simulation = GetSimulation())
+    {
+        // Client-side prediction (and the listen server host's own ball)
+        Simulation->SetInput(SimulationIndex, CachedForwardInput, CachedRightInput, Yaw);
+    }
+}
+
 //---------------Boost Replication------------------------------
 void ABallPawn::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps)  const
 {
     Super::GetLifetimeReplicatedProps(OutLifetimeProps);
 
-    DOREPLIFETIME(ABallPawn, bIsBoosting);
-    DOREPLIFETIME(ABallPawn, BoostTimeRemaining);
-    DOREPLIFETIME(ABallPawn, CooldownTimeRemaining);
+    // Only dirtied when a boost starts
+    FDoRepLifetimeParams BoostParams;
+    BoostParams.bIsPushBased = true;
+    DOREPLIFETIME_WITH_PARAMS_FAST(ABallPawn, BoostStartServerTime, BoostParams);
+
+    DOREPLIFETIME_CONDITION(ABallPawn, ReplicatedBallState, COND_SimulatedOnly);
+    DOREPLIFETIME_CONDITION(ABallPawn, ServerAck, COND_AutonomousOnly);
 }
 
-void ABallPawn::OnRep_IsBoosting()
+void ABallPawn::PreReplication(IRepChangedPropertyTracker& ChangedPropertyTracker)
 {
-    if (bIsBoosting)
+    Super::PreReplication(ChangedPropertyTracker);
+
+    if (HasAuthority() && MeshComp && MeshComp->IsSimulatingPhysics())
     {
-        TorqueStrength = BaseTorqueStrength * BoostMultiplier;
-        KnockImpulseStrength = BaseKnockImpulseStrength * BoostMultiplier;
+        ReplicatedBallState.FillFrom(*MeshComp, MeshComp->Bounds.SphereRadius);
+        ReplicatedBallState.SetTimestamp(GetServerTime());
     }
-    else
+}
+
+void ABallPawn::OnRep_BallState()
+{
+    if (!MeshComp || !Interpolation)
+    {
+        return;
+    }
+
+    // Buffered and played back InterpolationDelay behind the server clock by the simulation's pass
+    const double StateTime = ReplicatedBallState.GetTimestamp(GetServerTime());
+    Interpolation->AddSnapshot(ReplicatedBallState, StateTime, MeshComp->Bounds.SphereRadius);
+}
+
+void ABallPawn::OnRep_BoostStartTime()
+{
+    // The server confirmed a boost, which also answers any prediction we had pending
+    PredictedBoostStartTime = -1.0;
+    SyncBoostToSimulation();
+}
+
+void ABallPawn::Client_RejectBoost_Implementation()
+{
+    PredictedBoostStartTime = -1.0;
+    SyncBoostToSimulation();
+}
+
+double ABallPawn::GetServerTime() const
+{
+    return UBallGuysClockSubsystem::GetServerTime(GetWorld());
+}
+
+double ABallPawn::GetEffectiveBoostStartTime() const
+{
+    return PredictedBoostStartTime >= 0.0 ? PredictedBoostStartTime : BoostStartServerTime;
+}
+
+bool ABallPawn::IsBoosting() const
+{
+    return GetBoostTimeRemaining() > 0.f;
+}
+
+float ABallPawn::GetBoostTimeRemaining() const
+{
+    const double StartTime = GetEffectiveBoostStartTime();
+    if (StartTime < 0.0)
     {
-        TorqueStrength = BaseTorqueStrength;
-        KnockImpulseStrength = BaseKnockImpulseStrength;
+        return 0.f;
     }
+
+    return FMath::Max(static_cast<float>(StartTime + BoostDuration - GetServerTime()), 0.f);
+}
+
+float ABallPawn::GetCooldownTimeRemaining() const
+{
+    const double StartTime = GetEffectiveBoostStartTime();
+    if (StartTime < 0.0)
+    {
+        return 0.f;
+    }
+
+    // Cooldown starts with the boost, and can't be shorter than the boost itself
+    return FMath::Max(static_cast<float>(StartTime + FMath::Max(BoostCooldown, BoostDuration) - GetServerTime()), 0.f);
 }
 //---------Setting up Player Input Component--------------------
 void ABallPawn::SetupPlayerInputComponent(UInputComponent* PlayerInputComponent)
@@ -166,12 +375,7 @@ void ABallPawn::SetupPlayerInputComponent(UInputComponent* PlayerInputComponent)
                         Subsys->AddMappingContext(DefaultMappingContext, 0);
                     }
                     
-                    if (GEngine)
-                    {
-                        GEngine->AddOnScreenDebugMessage(
-                            -1, 5.f, FColor::Yellow,
-                            TEXT("Added DefaultMappingContext to local player"));
-                    }
+                    BALLGUYS_DEBUG_MESSAGE(1, 5.f, FColor::Yellow, TEXT("Added DefaultMappingContext to local player"));
                 }
             }
         }
@@ -182,6 +386,8 @@ void ABallPawn::SetupPlayerInputComponent(UInputComponent* PlayerInputComponent)
         if (MoveAction)
         {
             EnhancedInput->BindAction(MoveAction, ETriggerEvent::Triggered, this, &ABallPawn::HandleMove);
+            // Movement is held between events now, so releasing the stick has to clear it
+            EnhancedInput->BindAction(MoveAction, ETriggerEvent::Completed, this, &ABallPawn::HandleMove);
         }
         
         if (TurnAction)
@@ -227,54 +433,26 @@ void ABallPawn::SetupPlayerInputComponent(UInputComponent* PlayerInputComponent)
 void ABallPawn::HandleMove(const FInputActionValue& Value)
 {
     // Expecting a 2D axis (X = Right, Y = Forward)
-    const FVector2D MoveAxis = Value.Get<FVector2D>();
-    //DEBUG FOR CONTROLLER--------------
-    if (GEngine)
-    {
-        GEngine->AddOnScreenDebugMessage(
-            -1, 1.f, FColor::Green,
-            FString::Printf(TEXT("HandleMove: X=%.2f Y=%.2f  (Local=%d)"),
-                MoveAxis.X, MoveAxis.Y,
-                IsLocallyControlled() ? 1 : 0));
-    }
-    //----END DEBUG-------
-    const float ForwardValue = MoveAxis.Y;
-    const float RightValue   = MoveAxis.X;
-
-    // Cache if you still want, but main thing: send to server
-    CachedForwardInput = ForwardValue;
-    CachedRightInput   = RightValue;
-
-    // Get Control Rotation (Camera rotation)
-    FRotator ControlRot = FRotator::ZeroRotator;
-    if (AController* PC = GetController())
-    {
-        ControlRot = PC->GetControlRotation();
-    }
+    BALLGUYS_SCOPE(Input);
 
-    // Client-side prediction: Apply force immediately
-    ApplyMovementInput(ForwardValue, RightValue, ControlRot);
+    const FVector2D MoveAxis = Value.Get<FVector2D>();
+    BALLGUYS_DEBUG_MESSAGE(2, 1.f, FColor::Green, TEXT("HandleMove: X=%.2f Y=%.2f  (Local=%d)"),
+        MoveAxis.X, MoveAxis.Y, IsLocallyControlled() ? 1 : 0);
 
-    if (IsLocallyControlled())
-    {
-        Server_AddMovementInput(ForwardValue, RightValue, ControlRot);
-    }
+    // Only cached here; TickLocalControl hands it to the simulation and TickInputStream sends it to the server
+    CachedForwardInput = MoveAxis.Y;
+    CachedRightInput   = MoveAxis.X;
 }
 
 // Turn camera
 void ABallPawn::TurnCamera(const FInputActionValue& Value)
 {
+    BALLGUYS_SCOPE(Input);
+
     float Axis = Value.Get<float>();
-    //DEBUG FOR CONTROLLER--------------
-    if (GEngine)
-    {
-        GEngine->AddOnScreenDebugMessage(
-            -1, 1.f, FColor::Green,
-            FString::Printf(TEXT("TurnCamera: X=%.2f (Local=%d)"),
-                Axis,
-                IsLocallyControlled() ? 1 : 0));
-    }
-    //----END DEBUG-------
+    BALLGUYS_DEBUG_MESSAGE(2, 1.f, FColor::Green, TEXT("TurnCamera: X=%.2f (Local=%d)"),
+        Axis, IsLocallyControlled() ? 1 : 0);
+
     if (bInvertTurnAxis)
     {
         Axis *= -1.f;
@@ -285,17 +463,12 @@ void ABallPawn::TurnCamera(const FInputActionValue& Value)
 // LookUp camera
 void ABallPawn::LookUpCamera(const FInputActionValue& Value)
 {
+    BALLGUYS_SCOPE(Input);
+
     float Axis = Value.Get<float>();
-    //DEBUG FOR CONTROLLER--------------
-    if (GEngine)
-    {
-        GEngine->AddOnScreenDebugMessage(
-            -1, 1.f, FColor::Green,
-            FString::Printf(TEXT("LookUp: Y=%.2f  (Local=%d)"),
-                Axis,
-                IsLocallyControlled() ? 1 : 0));
-    }
-    //----END DEBUG-------
+    BALLGUYS_DEBUG_MESSAGE(2, 1.f, FColor::Green, TEXT("LookUp: Y=%.2f  (Local=%d)"),
+        Axis, IsLocallyControlled() ? 1 : 0);
+
     if (bInvertLookUpAxis)
     {
         Axis *= -1.f;
@@ -328,35 +501,47 @@ void ABallPawn::HandleInvertY(const FInputActionValue& Value)
     bInvertLookUpAxis = !bInvertLookUpAxis;
     // (Optional: notify UI here)
 }
+// ----------------- Scripted input (bots) -----------------
+
+void ABallPawn::SetScriptedMoveInput(const FVector2D& MoveAxis)
+{
+    HandleMove(FInputActionValue(MoveAxis));
+}
+
+void ABallPawn::PressScriptedJump()
+{
+    HandleJump(FInputActionValue(true));
+}
+
+void ABallPawn::PressScriptedBoost()
+{
+    HandleBoost(FInputActionValue(true));
+}
+
 //------------- Jump input -----------------------
 void ABallPawn::HandleJump(const FInputActionValue& Value)
 {
+    BALLGUYS_SCOPE(Input);
+
     // Digital action; we only care that it fired
     // Client-side prediction
     ApplyJump();
 
-    if (IsLocallyControlled())
+    if (IsLocallyControlled() && !HasAuthority())
     {
-        Server_Jump();
+        // Rides the next input frame to the server
+        PendingInputFlags |= EBallInputFlags::Jump;
     }
 }
 
 //--------------Boost Client-side input handler------------------
 void  ABallPawn::HandleBoost(const FInputActionValue& Value)
 {
+    BALLGUYS_SCOPE(Input);
+
     const bool bPressed = Value.Get<bool>();
-    // ---- DEBUG FOR CONTROLLER ----
-    if (GEngine)
-    {
-        GEngine->AddOnScreenDebugMessage(
-            -1, 1.5f, FColor::Green,
-            FString::Printf(TEXT("HandleBoost: Pressed=%d, Local=%d, Role=%d"),
-                bPressed ? 1 : 0,
-                IsLocallyControlled() ? 1 : 0,
-                static_cast<int32>(GetLocalRole()))
-        );
-    }
-    // ---- END DEBUG ----
+    BALLGUYS_DEBUG_MESSAGE(1, 1.5f, FColor::Green, TEXT("HandleBoost: Pressed=%d, Local=%d, Role=%d"),
+        bPressed ? 1 : 0, IsLocallyControlled() ? 1 : 0, static_cast<int32>(GetLocalRole()));
     
     // Only the locally controlled pawn should send the RPC
     if (!IsLocallyControlled())
@@ -369,228 +554,285 @@ void  ABallPawn::HandleBoost(const FInputActionValue& Value)
         return;  // We only care about the press not the release
     }
 
-    Server_TryBoost();
+    if (GetCooldownTimeRemaining() > 0.f)
+    {
+        return; // no point asking the server
+    }
+
+    if (HasAuthority())
+    {
+        TryStartBoost();
+    }
+    else
+    {
+        // Predict it now, the server confirms through BoostStartServerTime or rejects
+        PredictedBoostStartTime = GetServerTime();
+        PendingInputFlags |= EBallInputFlags::Boost;
+        SyncBoostToSimulation();
+    }
 }
 
-// ----------------- Shared Movement Logic -----------------
+// ----------------- Input stream -----------------
 
-void ABallPawn::ApplyMovementInput(float ForwardValue, float RightValue, const FRotator& ControlRot)
+void ABallPawn::TickInputStream(float DeltaSeconds)
 {
-    if (!MeshComp || !MeshComp->IsSimulatingPhysics())
+    // The listen server host applies its own input directly
+    if (HasAuthority())
     {
         return;
     }
 
-    // If the player isn't actually pressing anything, we can early-out
-    if (FMath::IsNearlyZero(ForwardValue) && FMath::IsNearlyZero(RightValue))
-    {
-        return;
-    }
+    const float SampleInterval = 1.f / FMath::Max(InputSampleRate, 1.f);
+    InputSampleAccumulator = FMath::Min(InputSampleAccumulator + DeltaSeconds, SampleInterval * 4.f);
 
-    // Use the PASSED ControlRot (which comes from client) instead of local controller
-    // This ensures Server moves in the direction the Client was looking.
+    while (InputSampleAccumulator >= SampleInterval)
+    {
+        InputSampleAccumulator -= SampleInterval;
 
-    // We only care about yaw (XZ plane)
-    FRotator YawRot(0.f, ControlRot.Yaw, 0.f);
+        FBallInputFrame Frame;
+        Frame.Sequence = NextInputSequence++;
+        Frame.SetAxes(CachedForwardInput, CachedRightInput);
+        if (AController* PC = GetController())
+        {
+            Frame.SetYaw(PC->GetControlRotation().Yaw);
+        }
+        Frame.Flags = PendingInputFlags;
+        PendingInputFlags = 0;
 
-    // Forward/right in world space based on camera/controller yaw
-    const FVector ForwardDir = FRotationMatrix(YawRot).GetUnitAxis(EAxis::X);
-    const FVector RightDir   = FRotationMatrix(YawRot).GetUnitAxis(EAxis::Y);
+        InputHistory.Add(Frame);
+        ++NumUnsentInputFrames;
 
-    // Desired move direction in the world
-    FVector MoveDir = ForwardDir * ForwardValue + RightDir * RightValue;
+        // Remember where we think we are as of this frame, so the server's ack can be checked against it
+        if (IsPredictingLocally())
+        {
+            FBallPredictedMove& Move = PredictionBuffer[Frame.Sequence % PredictionBufferSize];
+            Move.Sequence = Frame.Sequence;
+            Move.bValid   = true;
+            Move.State    = CapturePhysicsState();
+            Move.State.Location += PendingCorrection;
+        }
+    }
 
-    if (MoveDir.IsNearlyZero())
+    InputSendAccumulator += DeltaSeconds;
+    if (InputSendAccumulator >= 1.f / FMath::Max(InputSendRate, 1.f) && NumUnsentInputFrames > 0)
     {
-        return;
+        InputSendAccumulator = 0.f;
+        SendInputPacket();
     }
+}
+
+void ABallPawn::SendInputPacket()
+{
+    const int32 NumToSend = FMath::Min(NumUnsentInputFrames + InputRedundancy, FBallInputPacket::MaxFrames);
+    const int32 FirstToSend = FMath::Max(InputHistory.Num() - NumToSend, 0);
 
-    MoveDir.Normalize();
+    FBallInputPacket Packet;
+    Packet.Frames.Append(InputHistory.GetData() + FirstToSend, InputHistory.Num() - FirstToSend);
+    Server_SendInputs(Packet);
 
-    // TorqueAxis = MoveDir x Up
-    const FVector Up = FVector::UpVector;
-    FVector TorqueAxis = FVector::CrossProduct(Up, MoveDir);
+    NumUnsentInputFrames = 0;
 
-    if (TorqueAxis.IsNearlyZero())
+    // Only the redundant tail has to survive until the next packet
+    if (InputHistory.Num() > InputRedundancy)
     {
-        return;
+        InputHistory.RemoveAt(0, InputHistory.Num() - InputRedundancy, EAllowShrinking::No);
     }
+}
 
-    TorqueAxis.Normalize();
+// ----------------- Client-side prediction -----------------
 
-    const FVector Torque = TorqueAxis * TorqueStrength;
+bool ABallPawn::IsPredictingLocally() const
+{
+    return bEnableClientPrediction && IsLocallyControlled() && !HasAuthority();
+}
 
-    // Add torque in radians (physics-space)
-    MeshComp->AddTorqueInRadians(Torque, NAME_None, true);
+FBallPhysicsState ABallPawn::CapturePhysicsState() const
+{
+    FBallPhysicsState State;
+    if (MeshComp)
+    {
+        State.Location        = MeshComp->GetComponentLocation();
+        State.LinearVelocity  = MeshComp->GetPhysicsLinearVelocity();
+        State.AngularVelocity = MeshComp->GetPhysicsAngularVelocityInRadians();
+    }
+    return State;
 }
 
-void ABallPawn::ApplyJump()
+void ABallPawn::OnRep_ServerAck()
 {
-    if (!MeshComp || !MeshComp->IsSimulatingPhysics())
+    if (IsPredictingLocally())
+    {
+        CorrectPrediction(ServerAck);
+    }
+    else if (MeshComp && !HasAuthority())
+    {
+        // Not predicting: the ack is the only movement the owner gets, so just take it
+        MeshComp->SetWorldLocation(ServerAck.Location, false, nullptr, ETeleportType::TeleportPhysics);
+        MeshComp->SetPhysicsLinearVelocity(ServerAck.LinearVelocity);
+        MeshComp->SetPhysicsAngularVelocityInRadians(ServerAck.AngularVelocity);
+    }
+}
+
+void ABallPawn::CorrectPrediction(const FBallServerAck& Ack)
+{
+    if (!MeshComp || !MeshComp->IsSimulatingPhysics() || PredictionBuffer.Num() != PredictionBufferSize)
     {
         return;
     }
 
-    // Simple grounded check
-    if (!IsGrounded())
+    const FBallPredictedMove& Acked = PredictionBuffer[Ack.Sequence % PredictionBufferSize];
+    if (!Acked.bValid || Acked.Sequence != Ack.Sequence)
+    {
+        return; // too old, the slot has been reused
+    }
+
+    const FVector LocationError = Ack.Location - Acked.State.Location;
+    const FVector VelocityError = Ack.LinearVelocity - Acked.State.LinearVelocity;
+    if (LocationError.SizeSquared() < FMath::Square(CorrectionThreshold))
     {
         return;
     }
 
-    const FVector Impulse = FVector::UpVector * JumpImpulse;
-    MeshComp->AddImpulse(Impulse, NAME_None, true);
-}
+    // No replay: every state predicted after the ack moves by the same error. That matches re-running
+    // those inputs from the server's state only while nothing is hit in between.
+    const FVector AngularError = Ack.AngularVelocity - Acked.State.AngularVelocity;
+    for (uint16 Sequence = Ack.Sequence; Sequence != NextInputSequence; ++Sequence)
+    {
+        FBallPredictedMove& Move = PredictionBuffer[Sequence % PredictionBufferSize];
+        if (Move.bValid && Move.Sequence == Sequence)
+        {
+            Move.State.Location        += LocationError;
+            Move.State.LinearVelocity  += VelocityError;
+            Move.State.AngularVelocity += AngularError;
+        }
+    }
 
-//-----------Sever-side Boost logic----------------
-void ABallPawn::Server_TryBoost_Implementation()
-{
-    // DEBUG
-    if (GEngine)
+    // Velocity is corrected at once (it isn't visible), position is smoothed unless it's way off
+    MeshComp->SetPhysicsLinearVelocity(VelocityError, true);
+    MeshComp->SetPhysicsAngularVelocityInRadians(AngularError, true);
+
+    PendingCorrection += LocationError;
+    if (PendingCorrection.SizeSquared() > FMath::Square(CorrectionSnapThreshold))
     {
-        GEngine->AddOnScreenDebugMessage(
-            -1, 2.f, FColor::Yellow,
-            FString::Printf(TEXT("Server_TryBoost: Cooldown set to %.2f"), BoostCooldown)
-            );
+        MeshComp->SetWorldLocation(MeshComp->GetComponentLocation() + PendingCorrection, false, nullptr, ETeleportType::TeleportPhysics);
+        PendingCorrection = FVector::ZeroVector;
     }
-    
-    // Only the server controls the boost state
- if (bIsBoosting)
- {
-     return;  // already boosting
- }
-    if (CooldownTimeRemaining> 0.f)
+}
+
+void ABallPawn::TickPredictionCorrection(float DeltaSeconds)
+{
+    if (PendingCorrection.IsNearlyZero() || !MeshComp)
     {
-        return; // still on cooldown
+        return;
     }
 
-    // Start Boost
-    bIsBoosting           = true;
-    BoostTimeRemaining    = BoostDuration;
-    CooldownTimeRemaining = BoostCooldown;
+    const float Alpha = CorrectionSmoothingTime > 0.f ? FMath::Min(DeltaSeconds / CorrectionSmoothingTime, 1.f) : 1.f;
+    const FVector Step = PendingCorrection * Alpha;
 
-    // Apply boosted strengths
-    OnRep_IsBoosting();
-    
+    MeshComp->SetWorldLocation(MeshComp->GetComponentLocation() + Step, false, nullptr, ETeleportType::TeleportPhysics);
+    PendingCorrection -= Step;
 }
-// ----------------- Ground check -----------------
 
-bool ABallPawn::IsGrounded() const
+void ABallPawn::ProcessInputFrame(const FBallInputFrame& Frame)
 {
-    if (!MeshComp)
+    if (UBallSimulationSubsystem* Simulation = GetSimulation())
     {
-        return false;
+        Simulation->SetInput(SimulationIndex, Frame.GetForward(), Frame.GetRight(), Frame.GetYaw());
     }
 
-    UWorld* World = GetWorld();
-    if (!World)
+    if (Frame.HasFlag(EBallInputFlags::Jump))
     {
-        return false;
+        ApplyJump();
     }
 
-    //Centre of the ball and its radius
-    const FVector Center = MeshComp->GetComponentLocation();
-    const float Radius   = MeshComp->Bounds.SphereRadius;
-    
-    const FVector Start = Center;
-    const FVector End   = Center - FVector(0.f, 0.f, Radius + GroundCheckDistance);
-
-    FHitResult Hit;
-    FCollisionQueryParams Params(SCENE_QUERY_STAT(BallGroundCheck), false, this);
-
-    // Trace downwards – you might want ECC_WorldStatic / ECC_WorldDynamic
-    const bool bHit = World->SweepSingleByChannel(
-        Hit,
-        Start,
-        End,
-        FQuat::Identity,
-        ECC_WorldStatic,
-        FCollisionShape::MakeSphere(Radius * 0.9f),
-        Params
-    );
-
-    // Debug line (optional – comment out for production)
-    
-   /* const FColor Color = bHit ? FColor::Green : FColor::Red;
-    DrawDebugLine(World, Start, End, Color, false, 0.f, 0, 1.f);
-    DrawDebugSphere(World, End, Radius * 0.9f, 16, Color, false, 0.f); */
-     
-    return bHit;
+    if (Frame.HasFlag(EBallInputFlags::Boost) && !TryStartBoost())
+    {
+        Client_RejectBoost();
+    }
 }
 
-// ----------------- Collision: pushing other balls -----------------
+// ----------------- Shared Movement Logic -----------------
 
-void ABallPawn::NotifyHit(
-    UPrimitiveComponent* MyComp,
-    AActor* Other,
-    UPrimitiveComponent* OtherComp,
-    bool bSelfMoved,
-    FVector HitLocation,
-    FVector HitNormal,
-    FVector NormalImpulse,
-    const FHitResult& Hit
-)
+void ABallPawn::ApplyJump()
 {
-    Super::NotifyHit(MyComp, Other, OtherComp, bSelfMoved, HitLocation, HitNormal, NormalImpulse, Hit);
-
-    // Only the SERVER should apply shoving impulses, because it's authoritative.
-    if (!HasAuthority())
+    if (!MeshComp || !MeshComp->IsSimulatingPhysics())
     {
         return;
     }
 
-    if (!Other || !OtherComp)
+    // Cached grounded check, no scene query
+    if (!IsGrounded())
     {
         return;
     }
 
-    // Only shove other ABallPawn instances (other player balls)
-    ABallPawn* OtherBall = Cast<ABallPawn>(Other);
-    if (!OtherBall)
-    {
-        return;
-    }
+    const FVector Impulse = FVector::UpVector * JumpImpulse;
+    MeshComp->AddImpulse(Impulse, NAME_None, true);
 
-    if (!OtherComp->IsSimulatingPhysics())
+    // The contact we jumped off stays cached for a moment; don't let a second jump frame reuse it
+    if (UBallSimulationSubsystem* Simulation = GetSimulation())
     {
-        return;
+        Simulation->ClearGrounded(SimulationIndex);
     }
+}
+
+//-----------Sever-side Boost logic----------------
+bool ABallPawn::TryStartBoost()
+{
+    BALLGUYS_DEBUG_MESSAGE(1, 2.f, FColor::Yellow, TEXT("TryStartBoost: Cooldown set to %.2f"), BoostCooldown);
 
-    // Direction from us → them, so they get pushed away from us
-    FVector Dir = Other->GetActorLocation() - GetActorLocation();
-    if (Dir.IsNearlyZero())
+    // Only the server controls the boost state.
+    // The cooldown covers the boost itself, so this also rejects "already boosting".
+    if (GetCooldownTimeRemaining() > 0.f)
     {
-        return;
+        return false; // still on cooldown
     }
 
-    Dir.Normalize();
+    // Start Boost: one stamp, sent once; everyone works out the rest locally
+    BoostStartServerTime = GetServerTime();
+    MARK_PROPERTY_DIRTY_FROM_NAME(ABallPawn, BoostStartServerTime, this);
+    SyncBoostToSimulation();
+
+    return true;
+}
+// ----------------- Ground check -----------------
 
-    const FVector Impulse = Dir * KnockImpulseStrength;
+bool ABallPawn::IsGrounded() const
+{
+    // Kept up to date by contacts from the physics step and, when those go quiet, batched async sweeps
+    const UBallSimulationSubsystem* Simulation = GetSimulation();
+    return Simulation && Simulation->IsGrounded(SimulationIndex);
+}
 
-    // Apply impulse at the hit location for a more physical feel
-    OtherComp->AddImpulseAtLocation(Impulse, HitLocation);
+FVector ABallPawn::GetGroundNormal() const
+{
+    const UBallSimulationSubsystem* Simulation = GetSimulation();
+    return Simulation ? Simulation->GetGroundNormal(SimulationIndex) : FVector::UpVector;
 }
 
 // ----------------- Server RPC implementations -----------------
 
-void ABallPawn::Server_AddMovementInput_Implementation(float ForwardValue, float RightValue, FRotator ControlRot)
+void ABallPawn::Server_SendInputs_Implementation(const FBallInputPacket& Packet)
 {
-    // Server also applies the force (authoritative simulation)
-    // Avoid double application on Listen Server host
-    if (!IsLocallyControlled()) 
+    BALLGUYS_SCOPE(InputRPC);
+    CSV_CUSTOM_STAT(BallGuys, InputPackets, 1, ECsvCustomStatOp::Accumulate);
+
+    // Applied one frame per input step by the simulation, so a client sending more or burstier packets gets no more torque
+    if (UBallSimulationSubsystem* Simulation = GetSimulation())
     {
-        ApplyMovementInput(ForwardValue, RightValue, ControlRot);
+        Simulation->QueueInput(SimulationIndex, Packet);
     }
 }
 
-void ABallPawn::Server_Jump_Implementation()
+void ABallPawn::ConsumeInputFrame(const FBallInputFrame& Frame)
 {
-    // Only jump on server (authoritative)
-    // Avoid double application on Listen Server host
-    if (!IsLocallyControlled())
-    {
-        ApplyJump();
-    }
+    ProcessInputFrame(Frame);
+    CSV_CUSTOM_STAT(BallGuys, InputFramesProcessed, 1, ECsvCustomStatOp::Accumulate);
+
+    // Ack the newest frame with the state right after it, so the client compares like with like
+    const FBallPhysicsState State = CapturePhysicsState();
+    ServerAck.Sequence        = Frame.Sequence;
+    ServerAck.Location        = State.Location;
+    ServerAck.LinearVelocity  = State.LinearVelocity;
+    ServerAck.AngularVelocity = State.AngularVelocity;
 }
-
-
-
@@ -2,7 +2,7 @@
 // BallPawn.h
 // Simple rolling ball pawn for a multiplayer game.
 // - Physics-simulated sphere
-// - Server-authoritative movement (RPCs)
+// - Server-authoritative movement (unreliable, redundant input stream)
 // - Jump
 // - Push other balls on collision
 
@@ -13,6 +13,9 @@
 #include "InputActionValue.h"
 #include "Components/InputComponent.h"
 #include "Net/UnrealNetwork.h"
+#include "BallInputTypes.h"
+#include "BallPredictionTypes.h"
+#include "BallRepState.h"
 #include "BallPawn.generated.h" // "...generated.h ALWAYS LAST in #include(s)
 
 
@@ -22,6 +25,7 @@ class USpringArmComponent;
 class UCameraComponent;
 class UInputMappingContext;
 class UInputAction;
+class UBallInterpolationComponent;
 
 UCLASS()
 class BALLGUYS_API ABallPawn : public APawn
@@ -32,15 +36,48 @@ public:
     // Sets default values for this pawn's properties
     ABallPawn();
 
-    // Called every frame
-    virtual void Tick(float DeltaSeconds) override;
+    // No actor Tick: UBallSimulationSubsystem steps every ball in one pass and calls TickLocalControl on ours
+
+    /** Owning client / listen host only: correct, sample and send input, and hand it to the simulation. */
+    void TickLocalControl(float DeltaSeconds);
+
+    /** Server: applies one remote input frame. Called by UBallSimulationSubsystem once per input step while our queue has frames. */
+    void ConsumeInputFrame(const FBallInputFrame& Frame);
+
+    /** Called by UBallSimulationSubsystem when our slot moves. */
+    void SetSimulationIndex(int32 NewIndex) { SimulationIndex = NewIndex; }
 
     // Called to bind functionality to input
     virtual void SetupPlayerInputComponent(class UInputComponent* PlayerInputComponent) override;
 
+    // Server: refresh ReplicatedBallState only when the pawn is actually about to replicate
+    virtual void PreReplication(IRepChangedPropertyTracker& ChangedPropertyTracker) override;
+
 protected:
     // Called when the game starts or when spawned
     virtual void BeginPlay() override;
+    virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+    // Keeps the simulation's "locally controlled" flag in sync with possession
+    virtual void NotifyControllerChanged() override;
+
+    /** Our slot in UBallSimulationSubsystem, INDEX_NONE when not registered. */
+    int32 SimulationIndex = INDEX_NONE;
+
+    class UBallSimulationSubsystem* GetSimulation() const;
+
+    /** Pushes the boost start this machine acts on to the simulation. */
+    void SyncBoostToSimulation();
+
+    /** Clients: balls we don't control are kinematic and follow Interpolation; ours (and everything on the server) simulate. */
+    void UpdateSimulationMode();
+
+    /** Caps the body's linear speed at what FBallRepState can carry. The cap lives on the physics particle,
+     *  so it's applied again whenever the body is recreated or starts simulating again. */
+    void ApplyMaxLinearSpeed();
+
+    UFUNCTION()
+    void OnMeshPhysicsStateChanged(UPrimitiveComponent* ChangedComponent, EComponentPhysicsStateChange StateChange);
 
     /** Root + visual + physics body.
      *  Intentionally a StaticMeshComponent so it can simulate physics and collide.
@@ -57,6 +94,13 @@ protected:
     UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Components")
     UCameraComponent* Camera;
 
+    /** Server: sitting in the game mode's pool. */
+    bool bPooled = false;
+
+    /** Clients: buffers ReplicatedBallState and moves the body when this ball isn't ours. */
+    UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Components")
+    UBallInterpolationComponent* Interpolation;
+
     //---- Enhanced Input-------
 
     /** Mapping context for this pawn (move, look, jump). Assign IMC_BallPawn in BP. */
@@ -110,25 +154,62 @@ protected:
     UPROPERTY(EditAnywhere, BlueprintReadOnly, Category="Boost")
     float BoostCooldown = 5.f;
 
-    /** True while the boost is active. Replicated for UI / FX. */
-    UPROPERTY(ReplicatedUsing=OnRep_IsBoosting, BlueprintReadOnly, Category="Boost")
-    bool bIsBoosting = false;
+    /** Server time the current (or last) boost started at. Replicated once per boost, push-model.
+     *  Remaining boost and cooldown are computed locally from it, so nothing is sent while they run down. */
+    UPROPERTY(ReplicatedUsing=OnRep_BoostStartTime)
+    double BoostStartServerTime = -1.0;
 
     UFUNCTION()
-    void OnRep_IsBoosting();
+    void OnRep_BoostStartTime();
+
+    /** Owning client: when it predicted a boost the server hasn't confirmed yet. Negative when nothing is pending. */
+    double PredictedBoostStartTime = -1.0;
+
+    /** Server rejected our predicted boost (we were still on cooldown on its clock). */
+    UFUNCTION(Client, Reliable)
+    void Client_RejectBoost();
+
+    /** Boost start this machine should act on: the prediction while one is pending, otherwise the server's. */
+    double GetEffectiveBoostStartTime() const;
+
+    /** Server time as this machine knows it, from UBallGuysClockSubsystem. */
+    double GetServerTime() const;
+
+public:
+    UFUNCTION(BlueprintPure, Category="Boost")
+    bool IsBoosting() const;
 
     /** Time left on the current boost (seconds). */
-    UPROPERTY(Replicated, BlueprintReadOnly, Category="Boost")
-    float BoostTimeRemaining = 0.f;
+    UFUNCTION(BlueprintPure, Category="Boost")
+    float GetBoostTimeRemaining() const;
 
     /** Time left on cooldown before we can boost again (seconds). */
-    UPROPERTY(Replicated, BlueprintReadOnly, Category="Boost")
-    float CooldownTimeRemaining = 0.f;
+    UFUNCTION(BlueprintPure, Category="Boost")
+    float GetCooldownTimeRemaining() const;
+
+    /** Torque/knock multiplier right now: BoostMultiplier while boosting, 1 otherwise. */
+    float GetBoostScale() const { return IsBoosting() ? BoostMultiplier : 1.f; }
+
+    // ----------------- Pooling (server) -----------------
+    // ABallGuysGameMode reuses balls across deaths and eliminations instead of destroying and spawning them
+
+    /** Takes the ball out of play while it waits in the pool: hidden, no collision, no physics.
+     *  Hidden and collision replicate, so clients keep the actor and its channel open. */
+    void SetPooled(bool bInPooled);
+
+    bool IsPooled() const { return bPooled; }
 
-    /** Base (non-boosted) values so we can restore after boost. */
-    float BaseTorqueStrength = 0.f;
-    float BaseKnockImpulseStrength = 0.f;
+    /** Puts the ball back into play at SpawnTransform as if it had just spawned: at rest, no boost, no ground, no rewind history. */
+    void ResetForRespawn(const FTransform& SpawnTransform);
 
+    // ----------------- Scripted input (bots) -----------------
+    // Same handlers the input actions call, so scripted input rides the normal input stream
+
+    void SetScriptedMoveInput(const FVector2D& MoveAxis);
+    void PressScriptedJump();
+    void PressScriptedBoost();
+
+protected:
     
     //---- Input handlers (client-side)------
     void HandleMove(const FInputActionValue& Value);
@@ -141,16 +222,15 @@ protected:
     void HandleInvertX(const FInputActionValue& Value);
     void HandleInvertY(const FInputActionValue& Value);
 
-    //------Boost input handler---------------------
     //------Boost input handler---------------------
     void HandleBoost(const FInputActionValue& Value);
 
+    /** Server-side boost start (authority decides). Returns false if still on cooldown. */
+    bool TryStartBoost();
+
     // ----------------- Shared Movement Logic (Client + Server) -----------------
     
-    /** Applies movement forces based on input. Called by both HandleMove (Client) and Server_AddMovementInput (Server). */
-    void ApplyMovementInput(float ForwardValue, float RightValue, const FRotator& ControlRot);
-
-    /** Applies jump impulse. Called by both HandleJump (Client) and Server_Jump (Server). */
+    /** Applies jump impulse. Called by both HandleJump (Client) and ProcessInputFrame (Server). */
     void ApplyJump();
     
     // ----------------- Movement tuning -----------------
@@ -163,13 +243,19 @@ protected:
     UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Ball|Movement")
     float JumpImpulse;
 
-    /** How far down we trace to check if the ball is on the ground. */
+    /** How far down the fallback sweep looks for ground when the ball hasn't had a contact recently. */
     UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Ball|Movement")
     float GroundCheckDistance;
 
-    /** Impulse strength applied to other balls when we hit them. */
-    UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Ball|Movement")
-    float KnockImpulseStrength;
+    /** Restitution of contacts with other balls; above 1 knocks them away harder than they came in,
+     *  but only for hits closing faster than KnockSpeedThreshold, slower ones bounce at most elastically.
+     *  While boosting we also count as BoostMultiplier times heavier in those contacts. */
+    UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Ball|Movement", meta = (ClampMin = "0", ClampMax = "2"))
+    float KnockRestitution;
+
+    /** Closing speed (cm/s) a hit on another ball needs before KnockRestitution may add energy to it. */
+    UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Ball|Movement", meta = (ClampMin = "0"))
+    float KnockSpeedThreshold;
 
     // ----------------- Client-side input cache -----------------
 
@@ -179,43 +265,112 @@ protected:
     /** Last frame's right input (from -1 to 1). Only meaningful on the owning client. */
     float CachedRightInput;
 
-    // ----------------- Server RPCs -----------------
+    // ----------------- Input stream -----------------
 
-    /** Server-side movement handler.
-     *  Called from the owning client with the latest axis values.
-     */
-    UFUNCTION(Server, Reliable)
-    void Server_AddMovementInput(float ForwardValue, float RightValue,
-        FRotator ControlRot /*added to fix client camera control*/);
+    /** How many input frames per second the owning client samples. */
+    UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Ball|Network")
+    float InputSampleRate = 60.f;
+
+    /** How many input packets per second the owning client sends. Each packet batches every frame sampled since the last one. */
+    UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Ball|Network")
+    float InputSendRate = 30.f;
+
+    /** How many already-sent frames are repeated in every packet, so a lost packet doesn't lose movement. */
+    UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Ball|Network", meta = (ClampMin = "0", ClampMax = "12"))
+    int32 InputRedundancy = 6;
+
+    /** Client: frames waiting to be sent, plus the last InputRedundancy frames already sent. Oldest first. */
+    TArray<FBallInputFrame> InputHistory;
+
+    /** Client: how many frames at the end of InputHistory the server hasn't been sent yet. */
+    int32 NumUnsentInputFrames = 0;
+
+    /** Client: sequence number for the next sampled frame. */
+    uint16 NextInputSequence = 0;
+
+    /** Client: jump/boost presses since the last sampled frame (EBallInputFlags). */
+    uint8 PendingInputFlags = 0;
+
+    float InputSampleAccumulator = 0.f;
+    float InputSendAccumulator = 0.f;
+
+    /** Samples input frames at InputSampleRate and sends them at InputSendRate. Owning client only. */
+    void TickInputStream(float DeltaSeconds);
+
+    // ----------------- Client-side prediction -----------------
+
+    /** If true, the owning client predicts its own ball and corrects it against ServerAck; otherwise it just takes the ack. */
+    UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Ball|Network")
+    bool bEnableClientPrediction = true;
+
+    /** Prediction error (cm) below which the client leaves its ball alone. */
+    UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Ball|Network")
+    float CorrectionThreshold = 10.f;
+
+    /** Prediction error (cm) above which the client snaps instead of smoothing. */
+    UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Ball|Network")
+    float CorrectionSnapThreshold = 300.f;
+
+    /** How long (seconds) a position correction is spread over. */
+    UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Ball|Network")
+    float CorrectionSmoothingTime = 0.1f;
+
+    /** Ring buffer of predicted states, indexed by input sequence. */
+    static constexpr int32 PredictionBufferSize = 128;
+    TArray<FBallPredictedMove> PredictionBuffer;
+
+    /** Position correction still to be blended into the body. */
+    FVector PendingCorrection = FVector::ZeroVector;
 
-    /** Server-side jump handler.
-     *  Called from the owning client when jump input is pressed.
+    /** Server: compact, timestamped physics state for everyone but the owner, which gets ServerAck instead. */
+    UPROPERTY(ReplicatedUsing=OnRep_BallState)
+    FBallRepState ReplicatedBallState;
+
+    UFUNCTION()
+    void OnRep_BallState();
+
+    /** Server: newest processed sequence and the state right after it. Owning client only. */
+    UPROPERTY(ReplicatedUsing=OnRep_ServerAck)
+    FBallServerAck ServerAck;
+
+    UFUNCTION()
+    void OnRep_ServerAck();
+
+    bool IsPredictingLocally() const;
+    FBallPhysicsState CapturePhysicsState() const;
+
+    /**
+     * Compares the ack with what we predicted for its sequence and, past CorrectionThreshold, shifts the ball
+     * and every state predicted since by the error. Not a rewind and replay: Chaos can't re-simulate one body
+     * on its own, so the inputs after the ack aren't re-run from the server's state. Anything they'd have
+     * played out differently from there (a wall hit sooner, a ledge missed) shows up as error in later acks.
      */
-    UFUNCTION(Server, Reliable)
-    void Server_Jump();
+    void CorrectPrediction(const FBallServerAck& Ack);
+
+    /** Blends PendingCorrection into the body. */
+    void TickPredictionCorrection(float DeltaSeconds);
 
-    /** Server-side Boost Handler to start boost (authority decides) */
-    UFUNCTION(Server, Reliable)
-    void Server_TryBoost();
+    /** Sends the unsent frames plus the redundant tail to the server. */
+    void SendInputPacket();
+
+    /** Applies one frame on the server: hands its axes to the simulation and fires its edge-triggered actions. */
+    void ProcessInputFrame(const FBallInputFrame& Frame);
+
+    // ----------------- Server RPCs -----------------
+
+    /** Server-side input handler. Queues the frames in UBallSimulationSubsystem's jitter buffer; nothing is applied here.
+     *  Unreliable on purpose: every packet repeats the last few frames, and the queue drops the ones it has seen.
+     */
+    UFUNCTION(Server, Unreliable)
+    void Server_SendInputs(const FBallInputPacket& Packet);
 
     // ----------------- Helpers -----------------
 
-    /** Simple ground check via line trace straight down from the ball. */
+    /** Cached ground check from UBallSimulationSubsystem. Cheap enough to call per input frame. */
     bool IsGrounded() const;
-    
-    /** Called whenever this actor's primitive component hits something.
-     *  We override this so we can knock other balls away on the server.
-     */
-    virtual void NotifyHit(
-        UPrimitiveComponent* MyComp,
-        AActor* Other,
-        UPrimitiveComponent* OtherComp,
-        bool bSelfMoved,
-        FVector HitLocation,
-        FVector HitNormal,
-        FVector NormalImpulse,
-        const FHitResult& Hit
-    ) override;
+
+    /** Normal of the ground we last touched. */
+    FVector GetGroundNormal() const;
 };
 
 
@@ -0,0 +1,43 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/NetSerialization.h"
+#include "BallPredictionTypes.generated.h"
+
+/** Rigid-body state of a ball at one point in time. */
+struct FBallPhysicsState
+{
+	FVector Location = FVector::ZeroVector;
+	FVector LinearVelocity = FVector::ZeroVector;
+	FVector AngularVelocity = FVector::ZeroVector; // radians
+};
+
+/** What the owning client predicted when it sampled an input frame. */
+struct FBallPredictedMove
+{
+	uint16 Sequence = 0;
+	bool bValid = false;
+	FBallPhysicsState State;
+};
+
+/**
+ * Sent to the owning client only: the newest input sequence the server applied,
+ * and the authoritative state right after applying it.
+ */
+USTRUCT()
+struct BALLGUYS_API FBallServerAck
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	uint16 Sequence = 0;
+
+	UPROPERTY()
+	FVector_NetQuantize100 Location = FVector::ZeroVector;
+
+	UPROPERTY()
+	FVector_NetQuantize10 LinearVelocity = FVector::ZeroVector;
+
+	UPROPERTY()
+	FVector_NetQuantize100 AngularVelocity = FVector::ZeroVector;
+};
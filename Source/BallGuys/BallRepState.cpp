@@ -0,0 +1,316 @@
+#include "BallRepState.h"
+#include "BallGuys.h"
+#include "BallPawn.h"
+#include "BallGuysNetProfiler.h"
+#include "Components/PrimitiveComponent.h"
+#include "Engine/Level.h"
+#include "Engine/LevelBounds.h"
+#include "Engine/World.h"
+#include "EngineUtils.h"
+#include "UObject/CoreNet.h"
+
+const FBox FBallRepState::DefaultArenaBounds(FVector(-65536.f, -65536.f, -16384.f), FVector(65536.f, 65536.f, 16384.f));
+FBox FBallRepState::ArenaBounds = FBallRepState::DefaultArenaBounds;
+
+namespace BallRepState
+{
+	/** The state exactly as it goes on the wire. */
+	struct FQuantized
+	{
+		uint32 Location[3] = {};
+		uint32 RotationIndex = 0;
+		uint32 Rotation[3] = {};
+		uint32 LinearVelocity[3] = {};
+		uint32 AngularVelocity[3] = {};
+		bool bAngularFromRolling = false;
+	};
+
+	uint32 QuantizeRange(double Value, double Min, double Max, int32 Bits)
+	{
+		const uint32 MaxInt = (1u << Bits) - 1;
+		const double Alpha = FMath::Clamp((Value - Min) / (Max - Min), 0.0, 1.0);
+		return static_cast<uint32>(FMath::RoundToInt64(Alpha * MaxInt));
+	}
+
+	double DequantizeRange(uint32 Value, double Min, double Max, int32 Bits)
+	{
+		const uint32 MaxInt = (1u << Bits) - 1;
+		return Min + (Max - Min) * (static_cast<double>(Value) / MaxInt);
+	}
+
+	void QuantizeVector(const FVector& Value, double Range, int32 Bits, uint32 (&Out)[3])
+	{
+		for (int32 Axis = 0; Axis < 3; ++Axis)
+		{
+			Out[Axis] = QuantizeRange(Value[Axis], -Range, Range, Bits);
+		}
+	}
+
+	/** Logs the first value that doesn't fit its range; after that they're only clamped. */
+	void WarnOnceIfClamped(bool bClamped, bool& bWarned, const TCHAR* What, const FVector& Value, const FString& Range)
+	{
+		if (bClamped && !bWarned)
+		{
+			bWarned = true;
+			UE_LOG(LogBallGuys, Warning, TEXT("Ball state: %s %s is outside %s and gets clamped (only logged once)"), What, *Value.ToString(), *Range);
+		}
+	}
+
+	bool bWarnedLocation = false;
+	bool bWarnedLinearVelocity = false;
+	bool bWarnedAngularVelocity = false;
+
+	FVector DequantizeVector(const uint32 (&In)[3], double Range, int32 Bits)
+	{
+		return FVector(
+			DequantizeRange(In[0], -Range, Range, Bits),
+			DequantizeRange(In[1], -Range, Range, Bits),
+			DequantizeRange(In[2], -Range, Range, Bits));
+	}
+
+	FQuantized Quantize(const FBallRepState& State)
+	{
+		FQuantized Q;
+
+		const FBox& Arena = FBallRepState::GetArenaBounds();
+		WarnOnceIfClamped(!Arena.IsInsideOrOn(State.Location), bWarnedLocation, TEXT("location"), State.Location, Arena.ToString());
+		Q.Location[0] = QuantizeRange(State.Location.X, Arena.Min.X, Arena.Max.X, FBallRepState::LocationBitsXY);
+		Q.Location[1] = QuantizeRange(State.Location.Y, Arena.Min.Y, Arena.Max.Y, FBallRepState::LocationBitsXY);
+		Q.Location[2] = QuantizeRange(State.Location.Z, Arena.Min.Z, Arena.Max.Z, FBallRepState::LocationBitsZ);
+
+		// Smallest three: drop the largest component, it follows from the unit length
+		const FQuat Rotation = State.Rotation.GetNormalized();
+		const double Components[4] = { Rotation.X, Rotation.Y, Rotation.Z, Rotation.W };
+		int32 Largest = 0;
+		for (int32 Index = 1; Index < 4; ++Index)
+		{
+			if (FMath::Abs(Components[Index]) > FMath::Abs(Components[Largest]))
+			{
+				Largest = Index;
+			}
+		}
+		const double Sign = Components[Largest] < 0.0 ? -1.0 : 1.0;
+		Q.RotationIndex = Largest;
+		for (int32 Index = 0, Out = 0; Index < 4; ++Index)
+		{
+			if (Index != Largest)
+			{
+				Q.Rotation[Out++] = QuantizeRange(Components[Index] * Sign, -UE_INV_SQRT_2, UE_INV_SQRT_2, FBallRepState::RotationBits);
+			}
+		}
+
+		WarnOnceIfClamped(State.LinearVelocity.GetAbsMax() > FBallRepState::MaxLinearSpeed, bWarnedLinearVelocity,
+			TEXT("linear velocity"), State.LinearVelocity, FString::Printf(TEXT("%.0f cm/s"), FBallRepState::MaxLinearSpeed));
+		QuantizeVector(State.LinearVelocity, FBallRepState::MaxLinearSpeed, FBallRepState::LinearVelocityBits, Q.LinearVelocity);
+
+		Q.bAngularFromRolling = State.bAngularFromRolling;
+		if (!Q.bAngularFromRolling)
+		{
+			WarnOnceIfClamped(State.AngularVelocity.GetAbsMax() > FBallRepState::MaxAngularSpeed, bWarnedAngularVelocity,
+				TEXT("angular velocity"), State.AngularVelocity, FString::Printf(TEXT("%.0f rad/s"), FBallRepState::MaxAngularSpeed));
+			QuantizeVector(State.AngularVelocity, FBallRepState::MaxAngularSpeed, FBallRepState::AngularVelocityBits, Q.AngularVelocity);
+		}
+
+		return Q;
+	}
+
+	void Dequantize(const FQuantized& Q, FBallRepState& State)
+	{
+		const FBox& Arena = FBallRepState::GetArenaBounds();
+		State.Location.X = DequantizeRange(Q.Location[0], Arena.Min.X, Arena.Max.X, FBallRepState::LocationBitsXY);
+		State.Location.Y = DequantizeRange(Q.Location[1], Arena.Min.Y, Arena.Max.Y, FBallRepState::LocationBitsXY);
+		State.Location.Z = DequantizeRange(Q.Location[2], Arena.Min.Z, Arena.Max.Z, FBallRepState::LocationBitsZ);
+
+		double Components[4];
+		double SumSquares = 0.0;
+		for (int32 Index = 0, In = 0; Index < 4; ++Index)
+		{
+			if (Index != static_cast<int32>(Q.RotationIndex))
+			{
+				Components[Index] = DequantizeRange(Q.Rotation[In++], -UE_INV_SQRT_2, UE_INV_SQRT_2, FBallRepState::RotationBits);
+				SumSquares += FMath::Square(Components[Index]);
+			}
+		}
+		Components[Q.RotationIndex] = FMath::Sqrt(FMath::Max(1.0 - SumSquares, 0.0));
+		State.Rotation = FQuat(Components[0], Components[1], Components[2], Components[3]).GetNormalized();
+
+		State.LinearVelocity = DequantizeVector(Q.LinearVelocity, FBallRepState::MaxLinearSpeed, FBallRepState::LinearVelocityBits);
+
+		State.bAngularFromRolling = Q.bAngularFromRolling;
+		State.AngularVelocity = Q.bAngularFromRolling
+			? FVector::ZeroVector
+			: DequantizeVector(Q.AngularVelocity, FBallRepState::MaxAngularSpeed, FBallRepState::AngularVelocityBits);
+	}
+}
+
+void FBallRepState::SetArenaBounds(const UWorld& World)
+{
+	// Saved with the map, so the server and every client come up with the same box
+	const ALevelBounds* LevelBounds = World.PersistentLevel ? World.PersistentLevel->LevelBoundsActor.Get() : nullptr;
+	const FBox Bounds = LevelBounds ? LevelBounds->GetComponentsBoundingBox(true) : FBox(ForceInit);
+
+	ArenaBounds = Bounds.IsValid ? Bounds.ExpandBy(ArenaMargin) : DefaultArenaBounds;
+
+	const FVector Size = ArenaBounds.GetSize();
+	UE_LOG(LogBallGuys, Log, TEXT("Ball state: arena %s%s, location steps %.3f cm (XY) / %.3f cm (Z)"),
+		*ArenaBounds.ToString(), Bounds.IsValid ? TEXT("") : TEXT(" (default, the level has no bounds)"),
+		FMath::Max(Size.X, Size.Y) / ((1 << LocationBitsXY) - 1), Size.Z / ((1 << LocationBitsZ) - 1));
+}
+
+FVector FBallRepState::DeriveRollingAngularVelocity(const FVector& InLinearVelocity, float Radius)
+{
+	if (Radius <= UE_KINDA_SMALL_NUMBER)
+	{
+		return FVector::ZeroVector;
+	}
+
+	// Contact point at rest: V + W x (-R * Up) = 0  =>  W = (Up x V) / R
+	return FVector::CrossProduct(FVector::UpVector, InLinearVelocity) / Radius;
+}
+
+void FBallRepState::FillFrom(const UPrimitiveComponent& Body, float Radius)
+{
+	Location        = Body.GetComponentLocation();
+	Rotation        = Body.GetComponentQuat();
+	LinearVelocity  = Body.GetPhysicsLinearVelocity();
+	AngularVelocity = Body.GetPhysicsAngularVelocityInRadians();
+
+	// Half a radian per second is well below what anyone can see on a rolling ball
+	const FVector Rolling = DeriveRollingAngularVelocity(LinearVelocity, Radius);
+	bAngularFromRolling = FVector::DistSquared(Rolling, AngularVelocity) < FMath::Square(0.5f);
+}
+
+void FBallRepState::SetTimestamp(double ServerTime)
+{
+	TimestampMs = static_cast<uint16>(static_cast<uint64>(FMath::Max(ServerTime, 0.0) * 1000.0) & 0xFFFF);
+}
+
+double FBallRepState::GetTimestamp(double ReferenceServerTime) const
+{
+	// Signed distance from the reference's low bits picks the nearest wrap
+	const int64 ReferenceMs = static_cast<int64>(FMath::Max(ReferenceServerTime, 0.0) * 1000.0);
+	const int16 Delta = static_cast<int16>(TimestampMs - static_cast<uint16>(ReferenceMs & 0xFFFF));
+	return (ReferenceMs + Delta) / 1000.0;
+}
+
+bool FBallRepState::NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess)
+{
+	FBallGuysNetProfiler::SerializeStruct(Ar, Map, TEXT("BallPawn"), TEXT("FBallRepState"), [this](FArchive& StructAr)
+	{
+		SerializePayload(StructAr);
+	});
+
+	bOutSuccess = !Ar.IsError();
+	return true;
+}
+
+void FBallRepState::SerializePayload(FArchive& Ar)
+{
+	BallRepState::FQuantized Q;
+	if (Ar.IsSaving())
+	{
+		Q = BallRepState::Quantize(*this);
+	}
+
+	Ar.SerializeBits(&Q.Location[0], LocationBitsXY);
+	Ar.SerializeBits(&Q.Location[1], LocationBitsXY);
+	Ar.SerializeBits(&Q.Location[2], LocationBitsZ);
+
+	Ar.SerializeBits(&Q.RotationIndex, 2);
+	for (uint32& Component : Q.Rotation)
+	{
+		Ar.SerializeBits(&Component, RotationBits);
+	}
+
+	for (uint32& Component : Q.LinearVelocity)
+	{
+		Ar.SerializeBits(&Component, LinearVelocityBits);
+	}
+
+	uint8 bRolling = Q.bAngularFromRolling ? 1 : 0;
+	Ar.SerializeBits(&bRolling, 1);
+	Q.bAngularFromRolling = bRolling != 0;
+	if (!Q.bAngularFromRolling)
+	{
+		for (uint32& Component : Q.AngularVelocity)
+		{
+			Ar.SerializeBits(&Component, AngularVelocityBits);
+		}
+	}
+
+	Ar.SerializeBits(&TimestampMs, TimestampBits);
+
+	if (Ar.IsLoading())
+	{
+		BallRepState::Dequantize(Q, *this);
+	}
+}
+
+bool FBallRepState::operator==(const FBallRepState& Other) const
+{
+	const BallRepState::FQuantized A = BallRepState::Quantize(*this);
+	const BallRepState::FQuantized B = BallRepState::Quantize(Other);
+
+	return FMemory::Memcmp(A.Location, B.Location, sizeof(A.Location)) == 0
+		&& A.RotationIndex == B.RotationIndex
+		&& FMemory::Memcmp(A.Rotation, B.Rotation, sizeof(A.Rotation)) == 0
+		&& FMemory::Memcmp(A.LinearVelocity, B.LinearVelocity, sizeof(A.LinearVelocity)) == 0
+		&& A.bAngularFromRolling == B.bAngularFromRolling
+		&& FMemory::Memcmp(A.AngularVelocity, B.AngularVelocity, sizeof(A.AngularVelocity)) == 0;
+}
+
+// Serializes every ball's current state both ways and prints the cost per ball per second
+static FAutoConsoleCommandWithWorld CompareBallStateBandwidthCommand(
+	TEXT("BallGuys.Net.CompareStateBandwidth"),
+	TEXT("Compares bytes per ball per second of FBallRepState against the generic FRepMovement path."),
+	FConsoleCommandWithWorldDelegate::CreateLambda([](UWorld* World)
+	{
+		int32 NumBalls = 0;
+		int64 RepMovementBits = 0;
+		int64 BallStateBits = 0;
+		float UpdateFrequency = 0.f;
+
+		for (TActorIterator<ABallPawn> It(World); It; ++It)
+		{
+			const UPrimitiveComponent* Body = Cast<UPrimitiveComponent>(It->GetRootComponent());
+			if (!Body)
+			{
+				continue;
+			}
+
+			FRepMovement RepMovement;
+			RepMovement.Location        = Body->GetComponentLocation();
+			RepMovement.Rotation        = Body->GetComponentRotation();
+			RepMovement.LinearVelocity  = Body->GetPhysicsLinearVelocity();
+			RepMovement.AngularVelocity = Body->GetPhysicsAngularVelocityInDegrees();
+			RepMovement.bRepPhysics     = true;
+
+			FBallRepState BallState;
+			BallState.FillFrom(*Body, Body->Bounds.SphereRadius);
+
+			bool bSuccess = false;
+			FNetBitWriter RepMovementWriter(nullptr, 4096);
+			RepMovement.NetSerialize(RepMovementWriter, nullptr, bSuccess);
+			FNetBitWriter BallStateWriter(nullptr, 4096);
+			BallState.NetSerialize(BallStateWriter, nullptr, bSuccess);
+
+			RepMovementBits += RepMovementWriter.GetNumBits();
+			BallStateBits   += BallStateWriter.GetNumBits();
+			UpdateFrequency  = It->GetNetUpdateFrequency();
+			++NumBalls;
+		}
+
+		if (NumBalls == 0)
+		{
+			UE_LOG(LogBallGuys, Display, TEXT("CompareStateBandwidth: no balls in the world"));
+			return;
+		}
+
+		const double RepMovementBytesPerSec = RepMovementBits / 8.0 / NumBalls * UpdateFrequency;
+		const double BallStateBytesPerSec   = BallStateBits / 8.0 / NumBalls * UpdateFrequency;
+		UE_LOG(LogBallGuys, Display, TEXT("CompareStateBandwidth: %d balls at %.0f Hz | FRepMovement %.1f bits (%.0f B/s per ball) | FBallRepState %.1f bits (%.0f B/s per ball) | %.0f%% saved"),
+			NumBalls, UpdateFrequency,
+			static_cast<double>(RepMovementBits) / NumBalls, RepMovementBytesPerSec,
+			static_cast<double>(BallStateBits) / NumBalls, BallStateBytesPerSec,
+			RepMovementBytesPerSec > 0.0 ? 100.0 * (1.0 - BallStateBytesPerSec / RepMovementBytesPerSec) : 0.0);
+	}));
@@ -0,0 +1,83 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "BallRepState.generated.h"
+
+class UWorld;
+
+/**
+ * Compact replicated physics state of one ball, sent to simulated proxies instead of FRepMovement.
+ * - Location is quantized inside the arena: the map's level bounds, the same on every machine
+ * - Rotation is smallest-three
+ * - Velocities are clamped to what the ball body allows
+ * Values outside their range are clamped, with a warning the first time.
+ * - Angular velocity is left out when the ball is rolling without slipping, it follows from the linear one
+ * - A 16-bit millisecond timestamp lets receivers buffer and interpolate states (UBallInterpolationComponent)
+ */
+USTRUCT()
+struct BALLGUYS_API FBallRepState
+{
+	GENERATED_BODY()
+
+	FVector Location = FVector::ZeroVector;
+	FQuat Rotation = FQuat::Identity;
+	FVector LinearVelocity = FVector::ZeroVector;
+	FVector AngularVelocity = FVector::ZeroVector; // radians
+
+	/** Set when AngularVelocity wasn't sent and should be rebuilt with DeriveRollingAngularVelocity. */
+	bool bAngularFromRolling = false;
+
+	/** Server time the state was captured at, in milliseconds, wrapping. Left out of ==: time passing alone is no reason to send. */
+	uint16 TimestampMs = 0;
+
+	void SetTimestamp(double ServerTime);
+
+	/** Server time of the state, unwrapped around ReferenceServerTime, which has to be within half a wrap (32 s) of it. */
+	double GetTimestamp(double ReferenceServerTime) const;
+
+	/** Where locations are quantized. Set by SetArenaBounds before anything replicates. */
+	static const FBox& GetArenaBounds() { return ArenaBounds; }
+
+	/** Takes the arena from World's persistent level bounds, padded by ArenaMargin, or DefaultArenaBounds if the level has none. */
+	static void SetArenaBounds(const UWorld& World);
+
+	// Quantization ranges, shared by server and clients
+	static const FBox DefaultArenaBounds;
+	static constexpr float ArenaMargin = 2000.f;    // cm around the level bounds, for balls launched above or falling off
+	static constexpr int32 LocationBitsXY = 21;     // 1/16 cm over 1.3 km of arena
+	static constexpr int32 LocationBitsZ = 19;      // 1/16 cm over 330 m of arena
+	static constexpr int32 RotationBits = 11;       // per smallest-three component
+	static constexpr float MaxLinearSpeed = 6000.f; // cm/s, also the body's max linear speed (ABallPawn::ApplyMaxLinearSpeed)
+	static constexpr int32 LinearVelocityBits = 16;
+	static constexpr float MaxAngularSpeed = 64.f;  // rad/s, keep in sync with the body's MaxAngularVelocity
+	static constexpr int32 AngularVelocityBits = 14;
+	static constexpr int32 TimestampBits = 16;      // wraps every 65 s
+
+	/** Angular velocity of a ball of Radius rolling without slipping on flat ground. */
+	static FVector DeriveRollingAngularVelocity(const FVector& InLinearVelocity, float Radius);
+
+	/** Fills the state from a simulating body, and decides whether angular velocity has to be sent. */
+	void FillFrom(const UPrimitiveComponent& Body, float Radius);
+
+	bool NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess);
+
+	/** The wire format; NetSerialize runs it through the bandwidth profiler. */
+	void SerializePayload(FArchive& Ar);
+
+	/** Equal if both would put the same bits on the wire, so sub-quantum jitter doesn't trigger a send. */
+	bool operator==(const FBallRepState& Other) const;
+	bool operator!=(const FBallRepState& Other) const { return !(*this == Other); }
+
+private:
+	static FBox ArenaBounds;
+};
+
+template<>
+struct TStructOpsTypeTraits<FBallRepState> : public TStructOpsTypeTraitsBase2<FBallRepState>
+{
+	enum
+	{
+		WithNetSerializer = true,
+		WithIdenticalViaEquality = true
+	};
+};
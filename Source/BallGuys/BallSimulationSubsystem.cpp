@@ -0,0 +1,779 @@
+#include "BallSimulationSubsystem.h"
+#include "BallGuys.h"
+#include "BallPawn.h"
+#include "BallContactModifier.h"
+#include "BallInterpolationComponent.h"
+#include "BallGuysClockSubsystem.h"
+#include "BallGuysEliminationSubsystem.h"
+#include "BallGuysForceFieldSubsystem.h"
+#include "BallGuysGameMode.h"
+#include "Async/ParallelFor.h"
+#include "Components/PrimitiveComponent.h"
+#include "Engine/World.h"
+#include "GameFramework/PlayerState.h"
+#include "Physics/Experimental/PhysScene_Chaos.h"
+#include "PBDRigidsSolver.h"
+#include "PhysicsProxy/SingleParticlePhysicsProxy.h"
+
+void FBallSimulationTickFunction::ExecuteTick(float DeltaTime, ELevelTick TickType, ENamedThreads::Type CurrentThread, const FGraphEventRef& MyCompletionGraphEvent)
+{
+	if (Target && TickType != LEVELTICK_ViewportsOnly)
+	{
+		Target->Step(DeltaTime);
+	}
+}
+
+FString FBallSimulationTickFunction::DiagnosticMessage()
+{
+	return TEXT("FBallSimulationTickFunction");
+}
+
+bool UBallSimulationSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UBallSimulationSubsystem::OnWorldComponentsUpdated(UWorld& InWorld)
+{
+	Super::OnWorldComponentsUpdated(InWorld);
+
+	// Once the level is in and before any ball state arrives, on the server and on clients alike
+	FBallRepState::SetArenaBounds(InWorld);
+}
+
+void UBallSimulationSubsystem::OnWorldBeginPlay(UWorld& InWorld)
+{
+	Super::OnWorldBeginPlay(InWorld);
+
+	TickFunction.Target = this;
+	TickFunction.bCanEverTick = true;
+	TickFunction.bStartWithTickEnabled = true;
+	TickFunction.TickGroup = TG_PrePhysics;
+	TickFunction.RegisterTickFunction(InWorld.PersistentLevel);
+
+	if (FPhysScene* PhysScene = InWorld.GetPhysicsScene())
+	{
+		ContactModifier = PhysScene->GetSolver()->CreateAndRegisterSimCallbackObject_External<FBallContactModifier>();
+	}
+}
+
+void UBallSimulationSubsystem::Deinitialize()
+{
+	if (TickFunction.IsTickFunctionRegistered())
+	{
+		TickFunction.UnRegisterTickFunction();
+	}
+	TickFunction.Target = nullptr;
+
+	if (ContactModifier)
+	{
+		const UWorld* World = GetWorld();
+		if (FPhysScene* PhysScene = World ? World->GetPhysicsScene() : nullptr)
+		{
+			PhysScene->GetSolver()->UnregisterAndFreeSimCallbackObject_External(ContactModifier);
+		}
+		ContactModifier = nullptr;
+	}
+
+	Super::Deinitialize();
+}
+
+int32 UBallSimulationSubsystem::RegisterBall(ABallPawn* Pawn, UPrimitiveComponent* Body, const FBallTuning& InTuning)
+{
+	const int32 Index = Pawns.Add(Pawn);
+	Bodies.Add(Body);
+	Interpolations.Add(nullptr);
+	InputForward.Add(0.f);
+	InputRight.Add(0.f);
+	InputYaw.Add(0.f);
+	BoostStartTime.Add(-1.0);
+	Tuning.Add(InTuning);
+	LocallyControlled.Add(0);
+	GroundTime.Add(-1.0);
+	GroundNormal.Add(FVector::UpVector);
+	GroundQuery.AddDefaulted();
+	InputQueues.AddDefaulted();
+	InputStepAccumulator.Add(0.f);
+	History.AddDefaulted(HistoryFrames);
+	HistoryStartTime.Add(GetServerTime());
+	RewindKnockTime.Add(-1.0);
+	Eliminated.Add(0);
+
+	// Kill zones catch a ball as soon as its edge is in, not its centre
+	if (UBallGuysEliminationSubsystem* Eliminations = GetWorld()->GetSubsystem<UBallGuysEliminationSubsystem>())
+	{
+		Eliminations->SetBallRadius(Body ? Body->Bounds.SphereRadius : 0.f);
+	}
+
+	return Index;
+}
+
+void UBallSimulationSubsystem::UnregisterBall(int32 Index)
+{
+	if (!Pawns.IsValidIndex(Index))
+	{
+		return;
+	}
+
+	// The last block of history moves into the hole, like the last slot of every other array
+	const int32 LastIndex = Pawns.Num() - 1;
+	if (Index != LastIndex)
+	{
+		FMemory::Memcpy(&History[Index * HistoryFrames], &History[LastIndex * HistoryFrames], HistoryFrames * sizeof(FBallHistorySample));
+	}
+	History.SetNum(LastIndex * HistoryFrames, EAllowShrinking::No);
+
+	// Swap-remove every array the same way, then tell the ball that moved into the hole
+	Pawns.RemoveAtSwap(Index, 1, EAllowShrinking::No);
+	Bodies.RemoveAtSwap(Index, 1, EAllowShrinking::No);
+	Interpolations.RemoveAtSwap(Index, 1, EAllowShrinking::No);
+	InputForward.RemoveAtSwap(Index, 1, EAllowShrinking::No);
+	InputRight.RemoveAtSwap(Index, 1, EAllowShrinking::No);
+	InputYaw.RemoveAtSwap(Index, 1, EAllowShrinking::No);
+	BoostStartTime.RemoveAtSwap(Index, 1, EAllowShrinking::No);
+	Tuning.RemoveAtSwap(Index, 1, EAllowShrinking::No);
+	LocallyControlled.RemoveAtSwap(Index, 1, EAllowShrinking::No);
+	GroundTime.RemoveAtSwap(Index, 1, EAllowShrinking::No);
+	GroundNormal.RemoveAtSwap(Index, 1, EAllowShrinking::No);
+	GroundQuery.RemoveAtSwap(Index, 1, EAllowShrinking::No);
+	InputQueues.RemoveAtSwap(Index, 1, EAllowShrinking::No);
+	InputStepAccumulator.RemoveAtSwap(Index, 1, EAllowShrinking::No);
+	HistoryStartTime.RemoveAtSwap(Index, 1, EAllowShrinking::No);
+	RewindKnockTime.RemoveAtSwap(Index, 1, EAllowShrinking::No);
+	Eliminated.RemoveAtSwap(Index, 1, EAllowShrinking::No);
+
+	if (Pawns.IsValidIndex(Index) && Pawns[Index])
+	{
+		Pawns[Index]->SetSimulationIndex(Index);
+	}
+}
+
+void UBallSimulationSubsystem::GetBallLocationsInPlay(TArray<FVector>& OutLocations, TConstArrayView<const AActor*> Ignore) const
+{
+	OutLocations.Reset(Pawns.Num());
+	for (int32 Index = 0; Index < Pawns.Num(); ++Index)
+	{
+		const UPrimitiveComponent* Body = Bodies[Index];
+		if (Body && Body->IsSimulatingPhysics() && !Ignore.Contains(Pawns[Index]))
+		{
+			OutLocations.Add(Body->GetComponentLocation());
+		}
+	}
+}
+
+void UBallSimulationSubsystem::SetInput(int32 Index, float Forward, float Right, float Yaw)
+{
+	if (Pawns.IsValidIndex(Index))
+	{
+		InputForward[Index] = Forward;
+		InputRight[Index]   = Right;
+		InputYaw[Index]     = Yaw;
+	}
+}
+
+void UBallSimulationSubsystem::SetBoostStartTime(int32 Index, double StartTime)
+{
+	if (Pawns.IsValidIndex(Index))
+	{
+		BoostStartTime[Index] = StartTime;
+	}
+}
+
+void UBallSimulationSubsystem::SetLocallyControlled(int32 Index, bool bLocallyControlled)
+{
+	if (Pawns.IsValidIndex(Index))
+	{
+		LocallyControlled[Index] = bLocallyControlled ? 1 : 0;
+	}
+}
+
+void UBallSimulationSubsystem::SetInterpolation(int32 Index, UBallInterpolationComponent* Interpolation)
+{
+	if (Pawns.IsValidIndex(Index))
+	{
+		Interpolations[Index] = Interpolation;
+	}
+}
+
+void UBallSimulationSubsystem::ResetInput(int32 Index)
+{
+	if (Pawns.IsValidIndex(Index))
+	{
+		SetInput(Index, 0.f, 0.f, 0.f);
+		InputQueues[Index] = FBallInputQueue();
+		InputStepAccumulator[Index] = 0.f;
+	}
+}
+
+void UBallSimulationSubsystem::QueueInput(int32 Index, const FBallInputPacket& Packet)
+{
+	if (Pawns.IsValidIndex(Index))
+	{
+		InputQueues[Index].Push(Packet, Tuning[Index].InputStepInterval, GetWorld()->GetRealTimeSeconds());
+	}
+}
+
+void UBallSimulationSubsystem::ReportContact(int32 Index, const FVector& Normal)
+{
+	if (Pawns.IsValidIndex(Index) && Normal.Z >= GroundNormalMinZ)
+	{
+		GroundTime[Index]   = GetWorld()->GetTimeSeconds();
+		GroundNormal[Index] = Normal;
+	}
+}
+
+bool UBallSimulationSubsystem::IsGrounded(int32 Index) const
+{
+	return Pawns.IsValidIndex(Index)
+		&& GroundTime[Index] >= 0.0
+		&& GetWorld()->GetTimeSeconds() - GroundTime[Index] <= GroundContactLifetime;
+}
+
+FVector UBallSimulationSubsystem::GetGroundNormal(int32 Index) const
+{
+	return Pawns.IsValidIndex(Index) ? GroundNormal[Index] : FVector::UpVector;
+}
+
+void UBallSimulationSubsystem::ClearGrounded(int32 Index)
+{
+	if (Pawns.IsValidIndex(Index))
+	{
+		GroundTime[Index] = -1.0;
+		// A sweep in flight was sent before the jump
+		GroundQuery[Index] = FTraceHandle();
+	}
+}
+
+double UBallSimulationSubsystem::GetServerTime() const
+{
+	return UBallGuysClockSubsystem::GetServerTime(GetWorld());
+}
+
+void UBallSimulationSubsystem::Step(float DeltaSeconds)
+{
+	BALLGUYS_SCOPE(Simulation);
+
+	const int32 NumBalls = Pawns.Num();
+	CSV_CUSTOM_STAT(BallGuys, NumBalls, NumBalls, ECsvCustomStatOp::Set);
+	if (NumBalls == 0)
+	{
+		return;
+	}
+
+	// 1) Locally controlled balls (one per client, the host's on a listen server) sample,
+	//    send and correct their input; that's the only per-pawn call left in the frame
+	for (int32 Index = 0; Index < NumBalls; ++Index)
+	{
+		if (LocallyControlled[Index] && Pawns[Index])
+		{
+			Pawns[Index]->TickLocalControl(DeltaSeconds);
+		}
+	}
+
+	// Remote players' input, at a fixed rate no matter how their RPCs arrived,
+	// then their boosted hits against where they saw everyone
+	if (GetWorld()->GetNetMode() != NM_Client)
+	{
+		RecordHistory(GetServerTime());
+		EliminateBalls();
+		DrainInputQueues(DeltaSeconds);
+		ResolveRewoundKnocks(GetServerTime());
+	}
+	else
+	{
+		UpdateInterpolation();
+	}
+
+	UpdateContactModifier();
+	UpdateGroundQueries();
+
+	// 2) Torque for every ball from its held input, plain math over the arrays
+	const double Now = GetServerTime();
+	Torques.SetNumUninitialized(NumBalls, EAllowShrinking::No);
+
+	ParallelFor(NumBalls, [this, Now](int32 Index)
+	{
+		const float Forward = InputForward[Index];
+		const float Right   = InputRight[Index];
+		if (FMath::IsNearlyZero(Forward) && FMath::IsNearlyZero(Right))
+		{
+			Torques[Index] = FVector::ZeroVector;
+			return;
+		}
+
+		// We only care about yaw (XY plane)
+		const FRotationMatrix YawMatrix(FRotator(0.f, InputYaw[Index], 0.f));
+		const FVector MoveDir = (YawMatrix.GetUnitAxis(EAxis::X) * Forward + YawMatrix.GetUnitAxis(EAxis::Y) * Right).GetSafeNormal();
+
+		// TorqueAxis = Up x MoveDir
+		const FVector TorqueAxis = FVector::CrossProduct(FVector::UpVector, MoveDir).GetSafeNormal();
+
+		const FBallTuning& Ball = Tuning[Index];
+		const bool bBoosting = BoostStartTime[Index] >= 0.0 && Now - BoostStartTime[Index] < Ball.BoostDuration;
+
+		Torques[Index] = TorqueAxis * Ball.TorqueStrength * (bBoosting ? Ball.BoostMultiplier : 1.f);
+	}, NumBalls < ParallelThreshold ? EParallelForFlags::ForceSingleThread : EParallelForFlags::None);
+
+	// 3) Physics API calls stay on the game thread
+	for (int32 Index = 0; Index < NumBalls; ++Index)
+	{
+		if (!Torques[Index].IsZero() && Bodies[Index] && Bodies[Index]->IsSimulatingPhysics())
+		{
+			// Add torque in radians (physics-space)
+			Bodies[Index]->AddTorqueInRadians(Torques[Index], NAME_None, true);
+		}
+	}
+
+	// 4) Fans and jump pads, on the balls that are in one
+	ApplyForceFields();
+
+	// 5) Last, because a death can destroy a pawn and swap-remove its slot out of every array above
+	ReportDeaths();
+}
+
+void UBallSimulationSubsystem::ApplyForceFields()
+{
+	const UBallGuysForceFieldSubsystem* ForceFields = GetWorld()->GetSubsystem<UBallGuysForceFieldSubsystem>();
+	if (!ForceFields || ForceFields->GetNumFields() == 0)
+	{
+		return;
+	}
+
+	int32 NumInFields = 0;
+	for (int32 Index = 0; Index < Pawns.Num(); ++Index)
+	{
+		UPrimitiveComponent* Body = Bodies[Index];
+		if (!Body || !Body->IsSimulatingPhysics())
+		{
+			continue;
+		}
+
+		// One grid lookup; a ball away from every field stops here
+		const FVector Location = Body->GetComponentLocation();
+		const TArray<int32>* Candidates = ForceFields->FindCandidates(Location);
+		if (!Candidates)
+		{
+			continue;
+		}
+
+		FVector Acceleration;
+		FVector VelocityChange;
+		if (!ForceFields->Evaluate(*Candidates, Location, Body->GetPhysicsLinearVelocity(), Acceleration, VelocityChange))
+		{
+			continue;
+		}
+		++NumInFields;
+
+		if (!Acceleration.IsZero())
+		{
+			Body->AddForce(Acceleration, NAME_None, true);
+		}
+		if (!VelocityChange.IsZero())
+		{
+			Body->AddImpulse(VelocityChange, NAME_None, true);
+		}
+	}
+
+	CSV_CUSTOM_STAT(BallGuys, BallsInForceFields, NumInFields, ECsvCustomStatOp::Set);
+}
+
+void UBallSimulationSubsystem::DrainInputQueues(float DeltaSeconds)
+{
+	int32 NumDropped = 0;
+	int32 NumSkipped = 0;
+	int32 NumUnderruns = 0;
+	int32 MaxTargetDepth = 0;
+
+	for (int32 Index = 0; Index < Pawns.Num(); ++Index)
+	{
+		if (LocallyControlled[Index] || !Pawns[Index])
+		{
+			continue;
+		}
+
+		// A long hitch shouldn't turn into a burst bigger than the buffer could hold anyway
+		const float StepInterval = FMath::Max(Tuning[Index].InputStepInterval, KINDA_SMALL_NUMBER);
+		InputStepAccumulator[Index] = FMath::Min(InputStepAccumulator[Index] + DeltaSeconds, StepInterval * FBallInputQueue::MaxDepth);
+
+		FBallInputQueue& Queue = InputQueues[Index];
+		while (InputStepAccumulator[Index] >= StepInterval)
+		{
+			InputStepAccumulator[Index] -= StepInterval;
+
+			FBallInputFrame Frame;
+			if (Queue.Pop(Frame))
+			{
+				Pawns[Index]->ConsumeInputFrame(Frame);
+			}
+		}
+
+		NumDropped     += Queue.NumDropped;
+		NumSkipped     += Queue.NumSkipped;
+		NumUnderruns   += Queue.NumUnderruns;
+		MaxTargetDepth  = FMath::Max(MaxTargetDepth, Queue.GetTargetDepth());
+		Queue.ResetStats();
+	}
+
+	CSV_CUSTOM_STAT(BallGuys, InputFramesRedundant, NumDropped, ECsvCustomStatOp::Accumulate);
+	CSV_CUSTOM_STAT(BallGuys, InputFramesSkipped, NumSkipped, ECsvCustomStatOp::Accumulate);
+	CSV_CUSTOM_STAT(BallGuys, InputUnderruns, NumUnderruns, ECsvCustomStatOp::Accumulate);
+	CSV_CUSTOM_STAT(BallGuys, InputMaxBufferDepth, MaxTargetDepth, ECsvCustomStatOp::Set);
+}
+
+void UBallSimulationSubsystem::UpdateInterpolation()
+{
+	// Kinematic targets set before physics, so our own ball collides with where everyone is shown
+	const double Now = GetServerTime();
+	for (int32 Index = 0; Index < Pawns.Num(); ++Index)
+	{
+		if (Interpolations[Index] && Bodies[Index])
+		{
+			Interpolations[Index]->UpdateBody(*Bodies[Index], Now);
+		}
+	}
+}
+
+// ----------------- Lag compensation -----------------
+
+void UBallSimulationSubsystem::RecordHistory(double Now)
+{
+	// Positions as the last physics step left them
+	HistoryHead = (HistoryHead + 1) % HistoryFrames;
+	HistoryTime[HistoryHead] = Now;
+	NumHistoryFrames = FMath::Min(NumHistoryFrames + 1, HistoryFrames);
+
+	const int32 NumBalls = Pawns.Num();
+	LocationX.SetNumZeroed(NumBalls, EAllowShrinking::No);
+	LocationY.SetNumZeroed(NumBalls, EAllowShrinking::No);
+	LocationZ.SetNumZeroed(NumBalls, EAllowShrinking::No);
+
+	for (int32 Index = 0; Index < NumBalls; ++Index)
+	{
+		const UPrimitiveComponent* Body = Bodies[Index];
+		if (!Body)
+		{
+			continue;
+		}
+
+		const FVector3f Location(Body->GetComponentLocation());
+		LocationX[Index] = Location.X;
+		LocationY[Index] = Location.Y;
+		LocationZ[Index] = Location.Z;
+
+		FBallHistorySample& Sample = History[Index * HistoryFrames + HistoryHead];
+		Sample.Location       = Location;
+		Sample.LinearVelocity = Body->IsSimulatingPhysics() ? FVector3f(Body->GetPhysicsLinearVelocity()) : FVector3f::ZeroVector;
+	}
+}
+
+void UBallSimulationSubsystem::EliminateBalls()
+{
+	const UBallGuysEliminationSubsystem* Eliminations = GetWorld()->GetSubsystem<UBallGuysEliminationSubsystem>();
+	const ABallGuysGameMode* GameMode = GetWorld()->GetAuthGameMode<ABallGuysGameMode>();
+	if (!Eliminations || !GameMode || Eliminations->GetNumZones() == 0)
+	{
+		return;
+	}
+
+	Eliminations->FindBallsInZones(LocationX, LocationY, LocationZ, InEliminationZone);
+
+	// Dying respawns, pools or destroys the ball, which can't happen while Step is still walking the slots
+	for (int32 Index = 0; Index < Pawns.Num(); ++Index)
+	{
+		if (!InEliminationZone[Index] || Eliminated[Index] || !Pawns[Index] || !Bodies[Index] || !Bodies[Index]->IsSimulatingPhysics())
+		{
+			continue;
+		}
+
+		Eliminated[Index] = 1;
+		if (AController* Controller = Pawns[Index]->GetController())
+		{
+			PendingDeaths.AddUnique(Controller);
+		}
+	}
+}
+
+void UBallSimulationSubsystem::ReportDeaths()
+{
+	if (PendingDeaths.Num() == 0)
+	{
+		return;
+	}
+
+	CSV_CUSTOM_STAT(BallGuys, Eliminations, PendingDeaths.Num(), ECsvCustomStatOp::Accumulate);
+
+	// Taken out of the member first, so whatever PlayerDied sets off can't change the list we're walking
+	TArray<AController*> Died = MoveTemp(PendingDeaths);
+	PendingDeaths.Reset();
+
+	ABallGuysGameMode* GameMode = GetWorld()->GetAuthGameMode<ABallGuysGameMode>();
+	for (AController* Controller : Died)
+	{
+		if (GameMode && IsValid(Controller))
+		{
+			UE_LOG(LogBallGuys, Verbose, TEXT("Eliminated: %s"), *GetNameSafe(Controller->GetPawn()));
+			GameMode->PlayerDied(Controller);
+		}
+	}
+}
+
+void UBallSimulationSubsystem::ResetElimination(int32 Index)
+{
+	if (Eliminated.IsValidIndex(Index))
+	{
+		Eliminated[Index] = 0;
+	}
+}
+
+bool UBallSimulationSubsystem::GetRewoundState(int32 Index, double ServerTime, FVector& OutLocation, FVector& OutLinearVelocity) const
+{
+	if (!Pawns.IsValidIndex(Index) || NumHistoryFrames == 0 || ServerTime < HistoryStartTime[Index])
+	{
+		return false;
+	}
+
+	const FBallHistorySample* Samples = &History[Index * HistoryFrames];
+
+	// Walk back from the newest frame to the pair around ServerTime
+	int32 Newer = HistoryHead;
+	if (ServerTime >= HistoryTime[Newer])
+	{
+		OutLocation       = FVector(Samples[Newer].Location);
+		OutLinearVelocity = FVector(Samples[Newer].LinearVelocity);
+		return true;
+	}
+
+	for (int32 Age = 1; Age < NumHistoryFrames; ++Age)
+	{
+		const int32 Older = (HistoryHead - Age + HistoryFrames) % HistoryFrames;
+		if (HistoryTime[Older] <= ServerTime)
+		{
+			// Recorded before the ball's history starts: a previous life, or another ball's slot. Newer is the oldest we can trust
+			if (HistoryTime[Older] < HistoryStartTime[Index])
+			{
+				OutLocation       = FVector(Samples[Newer].Location);
+				OutLinearVelocity = FVector(Samples[Newer].LinearVelocity);
+				return true;
+			}
+
+			const double Span = HistoryTime[Newer] - HistoryTime[Older];
+			const float Alpha = Span > 0.0 ? static_cast<float>((ServerTime - HistoryTime[Older]) / Span) : 1.f;
+			OutLocation       = FVector(FMath::Lerp(Samples[Older].Location, Samples[Newer].Location, Alpha));
+			OutLinearVelocity = FVector(FMath::Lerp(Samples[Older].LinearVelocity, Samples[Newer].LinearVelocity, Alpha));
+			return true;
+		}
+		Newer = Older;
+	}
+
+	return false;
+}
+
+void UBallSimulationSubsystem::ResetHistory(int32 Index)
+{
+	if (Pawns.IsValidIndex(Index))
+	{
+		HistoryStartTime[Index] = GetServerTime();
+	}
+}
+
+void UBallSimulationSubsystem::ResolveRewoundKnocks(double Now)
+{
+	BALLGUYS_SCOPE(Knockback);
+
+	const int32 NumBalls = Pawns.Num();
+	for (int32 Attacker = 0; Attacker < NumBalls; ++Attacker)
+	{
+		// The host and bots play on the server's clock, nothing to compensate
+		UPrimitiveComponent* AttackerBody = Bodies[Attacker];
+		if (LocallyControlled[Attacker] || !Pawns[Attacker] || !AttackerBody || !AttackerBody->IsSimulatingPhysics())
+		{
+			continue;
+		}
+
+		const FBallTuning& AttackerTuning = Tuning[Attacker];
+		const bool bBoosting = BoostStartTime[Attacker] >= 0.0 && Now - BoostStartTime[Attacker] < AttackerTuning.BoostDuration;
+		const APlayerState* PlayerState = Pawns[Attacker]->GetPlayerState();
+		if (!bBoosting || !PlayerState)
+		{
+			continue;
+		}
+
+		// The frame we just applied was sampled a one-way trip ago, while the attacker showed everyone else
+		// RemoteViewDelay behind its server clock, and then waited in its input queue
+		const float Rewind = FMath::Min(
+			PlayerState->GetPingInMilliseconds() * 0.0005f + AttackerTuning.RemoteViewDelay + InputQueues[Attacker].Num() * AttackerTuning.InputStepInterval,
+			MaxRewindSeconds);
+		if (Rewind <= AttackerTuning.InputStepInterval)
+		{
+			continue;
+		}
+		const double ViewTime = Now - Rewind;
+
+		// The attacker predicts its own ball, so it was where the server has it now
+		const FVector AttackerLocation = AttackerBody->GetComponentLocation();
+		const FVector AttackerVelocity = AttackerBody->GetPhysicsLinearVelocity();
+		const float AttackerRadius = AttackerBody->Bounds.SphereRadius;
+
+		for (int32 Victim = 0; Victim < NumBalls; ++Victim)
+		{
+			UPrimitiveComponent* VictimBody = Bodies[Victim];
+			if (Victim == Attacker || !VictimBody || !VictimBody->IsSimulatingPhysics() || Now - RewindKnockTime[Victim] < RewindKnockCooldown)
+			{
+				continue;
+			}
+
+			FVector PastLocation, PastVelocity;
+			if (!GetRewoundState(Victim, ViewTime, PastLocation, PastVelocity))
+			{
+				continue;
+			}
+
+			const float Touching = AttackerRadius + VictimBody->Bounds.SphereRadius;
+			const FVector Offset = PastLocation - AttackerLocation;
+			if (Offset.SizeSquared() > FMath::Square(Touching + RewindHitTolerance))
+			{
+				continue;
+			}
+
+			// Touching here as well: the physics step resolves that one
+			if (FVector::DistSquared(VictimBody->GetComponentLocation(), AttackerLocation) <= FMath::Square(Touching + RewindHitTolerance))
+			{
+				continue;
+			}
+
+			const FVector Normal = Offset.GetSafeNormal();
+			const float ClosingSpeed = FVector::DotProduct(AttackerVelocity - PastVelocity, Normal);
+			if (ClosingSpeed <= 0.f)
+			{
+				continue;
+			}
+
+			// What the contact modifier gives a ball-ball contact between equal bodies: the higher restitution,
+			// and the boosting attacker BoostMultiplier times heavier
+			const float Restitution = FBallContactModifier::GetKnockRestitution(
+				FMath::Max(AttackerTuning.KnockRestitution, Tuning[Victim].KnockRestitution),
+				FMath::Max(AttackerTuning.KnockSpeedThreshold, Tuning[Victim].KnockSpeedThreshold),
+				ClosingSpeed);
+			const float MassRatio = FMath::Max(AttackerTuning.BoostMultiplier, 1.f);
+			const float Exchange = (1.f + Restitution) * ClosingSpeed / (MassRatio + 1.f);
+
+			VictimBody->AddImpulse(Normal * Exchange * MassRatio, NAME_None, true);
+			AttackerBody->AddImpulse(-Normal * Exchange, NAME_None, true);
+
+			RewindKnockTime[Victim] = Now;
+			CSV_CUSTOM_STAT(BallGuys, RewoundKnocks, 1, ECsvCustomStatOp::Accumulate);
+		}
+	}
+}
+
+void UBallSimulationSubsystem::UpdateContactModifier()
+{
+	if (!ContactModifier)
+	{
+		return;
+	}
+
+	const double Now = GetServerTime();
+	const int32 NumBalls = Pawns.Num();
+
+	FBallContactModifierInput* Input = ContactModifier->GetProducerInputData_External();
+	BallByParticle.Reset();
+
+	for (int32 Index = 0; Index < NumBalls; ++Index)
+	{
+		const FBodyInstance* BodyInstance = Bodies[Index] ? Bodies[Index]->GetBodyInstance() : nullptr;
+		const FPhysicsActorHandle Handle = BodyInstance ? BodyInstance->GetPhysicsActor() : nullptr;
+		if (!Handle)
+		{
+			continue;
+		}
+
+		const FBallTuning& Ball = Tuning[Index];
+		const bool bBoosting = BoostStartTime[Index] >= 0.0 && Now - BoostStartTime[Index] < Ball.BoostDuration;
+
+		FBallContactBall& Entry = Input->Balls.AddDefaulted_GetRef();
+		Entry.Particle       = Handle->GetGameThreadAPI().UniqueIdx().Idx;
+		Entry.Restitution    = Ball.KnockRestitution;
+		Entry.SpeedThreshold = Ball.KnockSpeedThreshold;
+		Entry.InvMassScale   = bBoosting && Ball.BoostMultiplier > 0.f ? 1.f / Ball.BoostMultiplier : 1.f;
+
+		BallByParticle.Add(Entry.Particle, Index);
+	}
+
+	// Ball-vs-world contacts from every physics step since last frame
+	while (Chaos::TSimCallbackOutputHandle<FBallContactModifierOutput> Output = ContactModifier->PopOutputData_External())
+	{
+		for (const FBallGroundContact& Contact : Output->GroundContacts)
+		{
+			if (const int32* Index = BallByParticle.Find(Contact.Particle))
+			{
+				ReportContact(*Index, Contact.Normal);
+			}
+		}
+	}
+}
+
+void UBallSimulationSubsystem::UpdateGroundQueries()
+{
+	UWorld* World = GetWorld();
+	const double Now = World->GetTimeSeconds();
+	const int32 NumBalls = Pawns.Num();
+
+	// Last frame's sweeps have finished by now
+	FTraceDatum Datum;
+	for (int32 Index = 0; Index < NumBalls; ++Index)
+	{
+		if (!GroundQuery[Index].IsValid())
+		{
+			continue;
+		}
+
+		if (World->QueryTraceData(GroundQuery[Index], Datum))
+		{
+			for (const FHitResult& Hit : Datum.OutHits)
+			{
+				if (Hit.bBlockingHit && Hit.ImpactNormal.Z >= GroundNormalMinZ)
+				{
+					GroundTime[Index]   = Now;
+					GroundNormal[Index] = Hit.ImpactNormal;
+					break;
+				}
+			}
+		}
+		GroundQuery[Index] = FTraceHandle();
+	}
+
+	// Balls resting or rolling on the floor keep reporting contacts; only the rest need a query.
+	// Sweep once a contact is half way to expiring, so the result lands before it does.
+	// Clients only ever jump their own ball, so they don't query the others.
+	const bool bIsClient = World->GetNetMode() == NM_Client;
+	for (int32 Index = 0; Index < NumBalls; ++Index)
+	{
+		UPrimitiveComponent* Body = Bodies[Index];
+		if (!Body || !Body->IsSimulatingPhysics() || (bIsClient && !LocallyControlled[Index]))
+		{
+			continue;
+		}
+		if (Now - GroundTime[Index] <= GroundContactLifetime * 0.5)
+		{
+			continue;
+		}
+
+		//Centre of the ball and its radius
+		const FVector Center = Body->GetComponentLocation();
+		const float Radius   = Body->Bounds.SphereRadius;
+		const FVector End    = Center - FVector(0.f, 0.f, Radius + Tuning[Index].GroundCheckDistance);
+
+		FCollisionQueryParams Params(SCENE_QUERY_STAT(BallGroundCheck), false, Pawns[Index]);
+
+		GroundQuery[Index] = World->AsyncSweepByChannel(
+			EAsyncTraceType::Single,
+			Center,
+			End,
+			FQuat::Identity,
+			ECC_WorldStatic,
+			FCollisionShape::MakeSphere(Radius * 0.9f),
+			Params
+		);
+	}
+}
@@ -0,0 +1,261 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/EngineBaseTypes.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "BallInputQueue.h"
+#include "WorldCollision.h"
+#include "BallSimulationSubsystem.generated.h"
+
+class ABallPawn;
+class AController;
+class FBallContactModifier;
+class UBallInterpolationComponent;
+class UBallSimulationSubsystem;
+class UPrimitiveComponent;
+
+/** Pre-physics tick for the whole ball simulation, so torque lands in the same frame's physics step. */
+USTRUCT()
+struct FBallSimulationTickFunction : public FTickFunction
+{
+	GENERATED_BODY()
+
+	UBallSimulationSubsystem* Target = nullptr;
+
+	virtual void ExecuteTick(float DeltaTime, ELevelTick TickType, ENamedThreads::Type CurrentThread, const FGraphEventRef& MyCompletionGraphEvent) override;
+	virtual FString DiagnosticMessage() override;
+};
+
+template<>
+struct TStructOpsTypeTraits<FBallSimulationTickFunction> : public TStructOpsTypeTraitsBase2<FBallSimulationTickFunction>
+{
+	enum
+	{
+		WithCopy = false
+	};
+};
+
+/** Per-ball tuning copied into the subsystem when the ball registers. */
+struct FBallTuning
+{
+	float TorqueStrength = 0.f;
+	float BoostMultiplier = 1.f;
+	float BoostDuration = 0.f;
+
+	/** How far below the ball's bottom the fallback ground sweep reaches (the pawn's GroundCheckDistance is relative to that). */
+	float GroundCheckDistance = 0.f;
+
+	/** Restitution of this ball's contacts with other balls (see FBallContactModifier). */
+	float KnockRestitution = 0.f;
+
+	/** Closing speed (cm/s) below which those contacts bounce at most elastically. */
+	float KnockSpeedThreshold = 0.f;
+
+	/** Time one input frame covers: the owning client's sample interval, and the server's step for draining its queue. */
+	float InputStepInterval = 1.f / 60.f;
+
+	/** How far behind the server clock clients show other balls (UBallInterpolationComponent::InterpolationDelay). */
+	float RemoteViewDelay = 0.f;
+};
+
+/** One ball's recorded state in the lag compensation history. Floats are plenty inside the arena. */
+struct FBallHistorySample
+{
+	FVector3f Location = FVector3f::ZeroVector;
+	FVector3f LinearVelocity = FVector3f::ZeroVector;
+};
+
+/**
+ * Owns the per-frame simulation of every ball in the world.
+ * Ball state lives here as parallel arrays (one slot per ball) and is stepped in one pass,
+ * in parallel once there are enough balls; pawns only feed it input and boost changes.
+ */
+UCLASS()
+class BALLGUYS_API UBallSimulationSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void OnWorldComponentsUpdated(UWorld& InWorld) override;
+	virtual void OnWorldBeginPlay(UWorld& InWorld) override;
+	virtual void Deinitialize() override;
+
+	/** Adds a ball and returns its slot. Slots move when other balls unregister; the pawn is told through SetSimulationIndex. */
+	int32 RegisterBall(ABallPawn* Pawn, UPrimitiveComponent* Body, const FBallTuning& Tuning);
+	void UnregisterBall(int32 Index);
+
+	void SetInput(int32 Index, float Forward, float Right, float Yaw);
+	void SetBoostStartTime(int32 Index, double StartTime);
+	void SetLocallyControlled(int32 Index, bool bLocallyControlled);
+
+	/** Clients: the ball follows Interpolation instead of simulating, or simulates again when null. */
+	void SetInterpolation(int32 Index, UBallInterpolationComponent* Interpolation);
+
+	/** Zero input and an empty input queue, for a ball that changes hands. */
+	void ResetInput(int32 Index);
+
+	/** Server: buffers a remote player's input packet. Frames are handed back to the pawn one per input step. */
+	void QueueInput(int32 Index, const FBallInputPacket& Packet);
+
+	int32 GetNumBalls() const { return Pawns.Num(); }
+
+	/** Where every ball in play (simulating, so not pooled) is, except the Ignore ones. */
+	void GetBallLocationsInPlay(TArray<FVector>& OutLocations, TConstArrayView<const AActor*> Ignore) const;
+
+	// ----------------- Ground state -----------------
+
+	/** Contact reported by the physics step. Counts as ground if the normal is walkable. */
+	void ReportContact(int32 Index, const FVector& Normal);
+
+	/** Cached: true if the ball touched walkable ground within the last GroundContactLifetime seconds. No scene query. */
+	bool IsGrounded(int32 Index) const;
+
+	/** Normal of the last walkable ground the ball touched. Up if it never has. */
+	FVector GetGroundNormal(int32 Index) const;
+
+	/** Forget the ground until the next contact, e.g. right after a jump so one contact can't be jumped off twice. */
+	void ClearGrounded(int32 Index);
+
+	/** How long a single ground contact keeps a ball grounded. */
+	static constexpr float GroundContactLifetime = 0.1f;
+
+	/** Contacts and sweep hits with a normal Z below this are walls, not ground. */
+	static constexpr float GroundNormalMinZ = 0.7f;
+
+	// ----------------- Lag compensation (server) -----------------
+
+	/** Where the ball was at ServerTime, interpolated from the history. False if that's older than the history, or than the ball. */
+	bool GetRewoundState(int32 Index, double ServerTime, FVector& OutLocation, FVector& OutLinearVelocity) const;
+
+	/** Forget the ball's history, e.g. after a teleport, so nothing gets rewound to where it used to be. */
+	void ResetHistory(int32 Index);
+
+	/** Frames of history per ball: a second at 60 fps, more than any rewind we allow. */
+	static constexpr int32 HistoryFrames = 64;
+
+	/** Longest rewind for a boosted hit, so a badly lagging attacker can't reach arbitrarily far into the past. */
+	static constexpr float MaxRewindSeconds = 0.3f;
+
+	/** How much further apart than touching two balls can be in the rewound frame and still count as a hit. */
+	static constexpr float RewindHitTolerance = 5.f;
+
+	/** A ball knocked by a rewound hit can't take another one for this long. */
+	static constexpr float RewindKnockCooldown = 0.3f;
+
+	// ----------------- Elimination (server) -----------------
+
+	/** A new life for the ball: it can be eliminated again (see EliminateBalls). */
+	void ResetElimination(int32 Index);
+
+	/** Steps every ball once. Called by the pre-physics tick function. */
+	void Step(float DeltaSeconds);
+
+	/** At or above this many balls, torques are computed with ParallelFor. */
+	static constexpr int32 ParallelThreshold = 64;
+
+protected:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+	FBallSimulationTickFunction TickFunction;
+
+	/** Registered with the world's physics solver; owned by the solver, freed in Deinitialize. */
+	FBallContactModifier* ContactModifier = nullptr;
+
+	/** Chaos particle index -> ball slot, rebuilt every step for reading the contact modifier's output. */
+	TMap<int32, int32> BallByParticle;
+
+	// ----------------- Ball state, one slot per ball -----------------
+
+	UPROPERTY()
+	TArray<ABallPawn*> Pawns;
+
+	UPROPERTY()
+	TArray<UPrimitiveComponent*> Bodies;
+
+	/** Clients: set for balls we don't control, which are moved by interpolation rather than simulated. */
+	UPROPERTY()
+	TArray<UBallInterpolationComponent*> Interpolations;
+
+	TArray<float> InputForward;
+	TArray<float> InputRight;
+	TArray<float> InputYaw;
+	TArray<double> BoostStartTime;
+	TArray<FBallTuning> Tuning;
+	TArray<uint8> LocallyControlled;
+
+	/** World time the ball last touched walkable ground, from a contact or a sweep. */
+	TArray<double> GroundTime;
+	TArray<FVector> GroundNormal;
+
+	/** Fallback sweep issued last frame for a ball with no recent contact; read back this frame. */
+	TArray<FTraceHandle> GroundQuery;
+
+	/**
+	 * Server: recent states of every ball in one allocation, one block of HistoryFrames per slot,
+	 * so a slot's history is History[Slot * HistoryFrames + Frame]. Frames are a ring shared by all
+	 * balls, HistoryHead is the newest.
+	 */
+	TArray<FBallHistorySample> History;
+	double HistoryTime[HistoryFrames] = {};
+	int32 HistoryHead = INDEX_NONE;
+	int32 NumHistoryFrames = 0;
+
+	/** Server time the ball's history starts at (registration or its last ResetHistory). */
+	TArray<double> HistoryStartTime;
+
+	/** Server time the ball last took a rewound knock. */
+	TArray<double> RewindKnockTime;
+
+	/** Server: set once a ball has been eliminated, until its next life, so it dies once however long it stays in a zone. */
+	TArray<uint8> Eliminated;
+
+	/** Server: every ball's location this step, one array per axis for the elimination pass, and that pass's result. */
+	TArray<float> LocationX;
+	TArray<float> LocationY;
+	TArray<float> LocationZ;
+	TArray<uint8> InEliminationZone;
+
+	/** Server: controllers eliminated this step. Told to the game mode at the end of Step, since that can unregister balls. */
+	UPROPERTY()
+	TArray<AController*> PendingDeaths;
+
+	/** Server: remote players' input, drained at each ball's InputStepInterval. */
+	TArray<FBallInputQueue> InputQueues;
+	TArray<float> InputStepAccumulator;
+
+	/** Output of the torque pass, applied to the bodies afterwards on the game thread. */
+	TArray<FVector> Torques;
+
+	double GetServerTime() const;
+
+	/** Clients: moves every interpolated ball to its delayed server state. */
+	void UpdateInterpolation();
+
+	/** Server: adds this frame's state of every ball to the history, and fills LocationX/Y/Z. */
+	void RecordHistory(double Now);
+
+	/** Server: every ball in play found inside an elimination zone dies, once per life. Queued in PendingDeaths. */
+	void EliminateBalls();
+
+	/** Server: hands PendingDeaths to the game mode, which respawns, pools or destroys their balls. */
+	void ReportDeaths();
+
+	/**
+	 * Server: a boosting remote player hits what it saw, not what the server has now.
+	 * Every other ball is rewound to the attacker's view time; one it overlaps there, but isn't touching
+	 * here, gets the knock the contact modifier would have given it.
+	 */
+	void ResolveRewoundKnocks(double Now);
+
+	/** Server: consumes one queued input frame per elapsed input step for every remote-controlled ball. */
+	void DrainInputQueues(float DeltaSeconds);
+
+	/** Sends this frame's balls to the contact modifier and reads back the contacts of the steps that finished. */
+	void UpdateContactModifier();
+
+	/** Pushes every simulating ball that's inside a force field (UBallGuysForceFieldSubsystem). Once per game frame, not per physics step. */
+	void ApplyForceFields();
+
+	/** Reads back last frame's ground sweeps and sends one async batch for every ball whose contacts went stale. */
+	void UpdateGroundQueries();
+};